@@ -20,560 +20,2007 @@
 
 // =========================================================================================== IMPORT
 
-#include "button_contol.h"
-#include <assert.h>
+#include "button_control.h"
+#include <string.h>
+
+#if BUTTON_CONTROL_VALIDATION
+    #include <assert.h>
+    #include <stdio.h>                          // For printf() of the validation messages
+#endif
+
+#if BUTTON_CONTROL_PROFILER
+    #include "esp_cpu.h"                        // For esp_cpu_get_cycle_count()
+#endif
+
+#include "esp_timer.h"                          // For esp_timer_get_time()
 
 // =========================================================================================== IMPORT
 
 
-// =========================================================================================== HELPER-FUNCTIONS
+// =========================================================================================== PROFILER
 
-// Fast read command function
-// (ordinary low-code read for ESP32 without many tests)
-static inline int fast_but_gpio_read(button_ctx *button)
-{
-    int raw_level;
+#if BUTTON_CONTROL_PROFILER
 
-    // Read
-    if (button->PIN < TOTAL_PINS)
-        raw_level = (GPIO.in >> button->PIN) & 0x1;
-    else
-        raw_level = (GPIO.in1.val >> (button->PIN - 32)) & 0x1;
+// Counters table and state of the currently measured API call
+static BUT_DRAM_ATTR button_profiler_counter profiler_table[BUT_PROF_API_QUANTITY][BUT_PROF_SECTION_QUANTITY];
 
-    // 1 or 0 return with logic for different pull modes
-    switch (button->pull_mode)
-    {
-        case GPIO_PULLUP_ONLY: return (raw_level == 0);         // active-low
-        case GPIO_PULLDOWN_ONLY: return (raw_level == 1);       // active-high
-        case GPIO_FLOATING: return raw_level;                   // choose whatever      
-        case GPIO_PULLUP_PULLDOWN: return raw_level;            // choose whatever
-        default: return raw_level;
-    }
+static BUT_DRAM_ATTR button_profiler_api profiler_current_api;     // API of the measured call
+static BUT_DRAM_ATTR uint32_t profiler_nested_cycles;              // Cycles of the sections inside the measured call
+
+
+static inline uint32_t BUT_IRAM_ATTR profiler_cycles(void)
+{
+    return (uint32_t)esp_cpu_get_cycle_count();
 }
 
-// =========================================================================================== HELPER-FUNCTIONS
 
+static inline void BUT_IRAM_ATTR profiler_counter_add(button_profiler_counter *counter, uint32_t cycles)
+{
+    if (counter->calls == 0 || cycles < counter->min_cycles) counter->min_cycles = cycles;
+    if (cycles > counter->max_cycles) counter->max_cycles = cycles;
 
-// =========================================================================================== API REALIZATION
+    counter->total_cycles += cycles;
+    counter->calls += 1;
+}
 
 
-// Button constructor realization
-button_ctx button_initialization(gpio_num_t PIN, gpio_pull_mode_t pull_mode, button_type type)
+static inline void BUT_IRAM_ATTR profiler_section_add(button_profiler_section section, uint32_t cycles)
 {
-    // Check the data - assert if it's wrong
+    profiler_counter_add(&profiler_table[profiler_current_api][section], cycles);
+    profiler_nested_cycles += cycles;
+}
 
-    // Pin number error handler
-    if (PIN < 0 || PIN > TOTAL_PINS)
-    {
-        printf("Wrong pin number: %d (valid 0..%d)!\n", PIN, TOTAL_PINS);
-        assert(0);
-    }
 
-    // GPIO regime error handler
-    if (pull_mode != GPIO_PULLUP_ONLY &&
-        pull_mode != GPIO_PULLDOWN_ONLY &&
-        pull_mode != GPIO_PULLUP_PULLDOWN &&
-        pull_mode != GPIO_FLOATING)
-    {
-        printf("You've chosen the wrong pull mode: %d\n", pull_mode);
-        assert(0);
-    }
+static inline void BUT_IRAM_ATTR profiler_call_end(button_ctx *button, uint32_t call_start)
+{
+    uint32_t total = profiler_cycles() - call_start;
 
-    // Button type error handler
-    if (type != NO_FIX && type != FIX)
-    {
-        printf("You've chosen the wrong button type: %d\n", type);
-        assert(0);
-    }
+    profiler_counter_add(&profiler_table[profiler_current_api][BUT_PROF_SECTION_TOTAL], total);
+    profiler_counter_add(&profiler_table[profiler_current_api][BUT_PROF_SECTION_STATE_MACHINE],
+                         total - profiler_nested_cycles);
 
+    profiler_counter_add(&button->profiler, total);
+}
 
-    // Fill the struct with main user data
-    button_ctx new_button;
 
-    // First fill by user data
-    new_button.PIN = PIN;
-    new_button.pull_mode = pull_mode;
-    new_button.type = type;
+// Whole API call measurement (place after the early returns of the API)
+#define BUT_PROF_CALL_BEGIN(api)                                                \
+    uint32_t profiler_call_start = profiler_cycles();                           \
+    profiler_current_api = (api);                                               \
+    profiler_nested_cycles = 0
 
+#define BUT_PROF_CALL_END(button) profiler_call_end((button), profiler_call_start)
 
-    gpio_set_direction(new_button.PIN, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(new_button.PIN, new_button.pull_mode);
+// Section measurement inside the API call
+#define BUT_PROF_SECTION_BEGIN() uint32_t profiler_section_start = profiler_cycles()
+#define BUT_PROF_SECTION_END(section) profiler_section_add((section), profiler_cycles() - profiler_section_start)
 
-    
-    // First autofill of the other ctx data
-    new_button.but_pressed = false;
-    new_button.but_long_pressed = false;
-    new_button.but_snapshot = false;
+#else
 
-    new_button.one_time_block = false;
-    new_button.mt_permission = true;
+#define BUT_PROF_CALL_BEGIN(api)
+#define BUT_PROF_CALL_END(button)
+#define BUT_PROF_SECTION_BEGIN()
+#define BUT_PROF_SECTION_END(section)
 
-    new_button.long_time_await_end = true;
+#endif // BUTTON_CONTROL_PROFILER
 
-    new_button.presses_counter = 0;
-    new_button.max_presses_quantity = 1;
+// =========================================================================================== PROFILER
 
-    new_button.onetime_press_callback = NULL;
 
-    new_button.multiple_press_callback = NULL;
+// =========================================================================================== HELPER-FUNCTIONS
 
-    new_button.long_time_press_callback = NULL;
-    new_button.long_time_press_permission = false;
+static BUT_DRAM_ATTR button_bank_snapshot bank_latched;       // Latched GPIO levels of the current tick
+static BUT_DRAM_ATTR bool bank_latched_mode = false;          // Button reads from the latched snapshot
+
+#if BUTTON_CONTROL_ENCODER
+static BUT_DRAM_ATTR button_encoder *encoders[BUTTON_ENCODERS_MAX];       // Registered encoders
+static BUT_DRAM_ATTR uint8_t encoders_quantity = 0;
+static BUT_DRAM_ATTR button_bank_snapshot encoders_mask;                  // Pins of all registered encoders
+static BUT_DRAM_ATTR button_bank_snapshot encoders_previous;              // Snapshot of the previous decoding
+
+// Quadrature steps by the (previous AB << 2 | AB) transition: CW 00 -> 01 -> 11 -> 10 -> 00 is +1,
+// 0 for no change and for the skipped state (both channels changed)
+static BUT_DRAM_ATTR const int8_t encoder_steps_table[16] = {
+     0,  1, -1,  0,
+    -1,  0,  0,  1,
+     1,  0,  0, -1,
+     0, -1,  1,  0,
+};
+#endif
 
-    new_button.infinite_press_callback = NULL;
-    new_button.infinite_press_permission = false;
+#if BUTTON_CONTROL_SIM_INPUT
+static BUT_DRAM_ATTR button_input_source simulated_input_source = NULL;     // User input source (NULL - GPIO registers)
+static BUT_DRAM_ATTR button_bank_source simulated_bank_source = NULL;       // User bank source (NULL - GPIO registers)
+static BUT_DRAM_ATTR button_time_source simulated_time_source = NULL;       // User clock (NULL - esp_timer)
+#endif
 
-    // Awaits initialization
-    new_button.DEBOUNCE_AWAIT = async_await_ctx_default();
-    new_button.MULTIPRESS_AWAIT = async_await_ctx_default();
-    new_button.LONG_TIME_PRESS_AWAIT = async_await_ctx_default();
 
-    // Return the new button
-    return new_button; 
+// Current time of the engine (esp_timer or the simulated clock)
+static inline int64_t BUT_IRAM_ATTR but_time_now(void)
+{
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_time_source != NULL) return simulated_time_source();
+#endif
+
+    return esp_timer_get_time();
 }
 
 
+// Raw pin level from the input words by the chip layout
+// (the high bank branch is compiled out for the chips without GPIO_IN1_REG)
+static inline int BUT_IRAM_ATTR but_bank_level(uint32_t in, uint32_t in1, gpio_num_t PIN)
+{
+#if BUTTON_GPIO_HIGH_BANK
+    if (PIN >= BUTTON_GPIO_LOW_BANK_PINS) return (in1 >> (PIN - BUTTON_GPIO_LOW_BANK_PINS)) & 0x1;
+#else
+    (void)in1;
+#endif
 
-// Button control APIs realization
+    return (in >> PIN) & 0x1;
+}
 
-// Flags control
 
-// Switch the flag value by the short BUT press (flag holds the switched value, until the BUT pressed
-// once again)
-void flag_control_by_but_onetime_press(button_ctx *button, bool* flag)
+// Raw pin level by one input register read (GPIO_IN_REG or GPIO_IN1_REG by the chip layout)
+static inline int BUT_IRAM_ATTR but_gpio_level(gpio_num_t PIN)
 {
-    // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
+#if BUTTON_GPIO_HIGH_BANK
+    if (PIN >= BUTTON_GPIO_LOW_BANK_PINS) return (REG_READ(GPIO_IN1_REG) >> (PIN - BUTTON_GPIO_LOW_BANK_PINS)) & 0x1;
+#endif
 
-    // No option to work for button with fixation
-    if (button->type == FIX) return;
+    return (REG_READ(GPIO_IN_REG) >> PIN) & 0x1;
+}
 
-    // BUT state
-    int but_level = fast_but_gpio_read(button);
 
-    if (!button->but_pressed && but_level)
-    {
-        button->one_time_block = false; // Reset the timers for longtime check
-        
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {
-            button->but_pressed = true;
-            button->mt_permission = true; // Reset by the press if earlier flag blocked by long time press
-        }
-    }
-    // Reset for the next press if but was pressed, mt_permission was obtained
-    // and user don't hold the button no more.
-    else if (button->but_pressed && button->mt_permission && !button->one_time_block && !but_level)
+// Fast read command function
+// (ordinary low-code read: one input register by the chip layout)
+static inline int BUT_IRAM_ATTR fast_but_gpio_read(const button_ctx *button)
+{
+    int raw_level;
+
+    // Read
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_input_source != NULL)
+        raw_level = simulated_input_source(button) & 0x1;
+    else
+#endif
+    if (bank_latched_mode)
+        raw_level = but_bank_level(bank_latched.in, bank_latched.in1, button->PIN);
+    else
+        raw_level = but_gpio_level(button->PIN);
+
+    // 1 or 0 return with logic for different pull modes
+#if BUTTON_CONTROL_ACTIVE_LEVEL == BUTTON_ACTIVE_LOW
+    return (raw_level == 0);    // Same level for all buttons - no pull mode compare
+#elif BUTTON_CONTROL_ACTIVE_LEVEL == BUTTON_ACTIVE_HIGH
+    return raw_level;
+#else
+    // (compare instead of the switch - no jump table in the flash rodata for the IRAM poll path)
+    if (button->pull_mode == GPIO_PULLUP_ONLY) return (raw_level == 0);     // active-low
+
+    return raw_level;       // active-high for GPIO_PULLDOWN_ONLY, choose whatever for GPIO_FLOATING / GPIO_PULLUP_PULLDOWN
+#endif
+}
+
+
+// All input registers read (or the simulated bank)
+static inline void BUT_IRAM_ATTR but_bank_read(button_bank_snapshot *bank)
+{
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_bank_source != NULL)
     {
-        *flag = !*flag; // Change the flag
-        end_await(&button->DEBOUNCE_AWAIT); // Stop await
-        end_await(&button->LONG_TIME_PRESS_AWAIT);
-        
-        button->but_pressed = false; // Reset for the next call
-        button->one_time_block = true;
+        simulated_bank_source(bank);
+        return;
     }
+#endif
+
+    // Only the registers of the chip layout
+    bank->in = REG_READ(GPIO_IN_REG);
+#if BUTTON_GPIO_HIGH_BANK
+    bank->in1 = REG_READ(GPIO_IN1_REG);
+#else
+    bank->in1 = 0;
+#endif
 }
 
 
-// Switch the flag value by the several BUT presses (flag holds the switched value, until the BUT pressed
-// several times once again)
-void flag_control_by_but_multiple_press_inside(button_ctx *button, bool* flag, uint8_t presses_quantity)
+#if BUTTON_CONTROL_HEALTH
+static inline void but_health_sample(button_ctx *button, int but_level);      // Contact health update (below)
+#else
+#define but_health_sample(button, but_level) ((void)0)
+#endif
+
+
+// Button state read (sample section of the profiler)
+static inline int BUT_IRAM_ATTR but_sample(button_ctx *button)
 {
-    // Logic error handler
-    if (presses_quantity < 1) return;
+    BUT_PROF_SECTION_BEGIN();
 
-    // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
+    int but_level = fast_but_gpio_read(button);
 
-    // Update the maximum presses quantity value
-    if (presses_quantity > button->max_presses_quantity) button->max_presses_quantity = presses_quantity;
+    BUT_PROF_SECTION_END(BUT_PROF_SECTION_SAMPLE);
 
+    // Outside the sample section: the degrading contact event has its own section
+    but_health_sample(button, but_level);
 
-    // BUT state read
-    int but_level = fast_but_gpio_read(button);
+    return but_level;
+}
 
-    // One time press check
-    if (!button->but_pressed && but_level)
-    {
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {
-            button->mt_permission = true;
 
-            button->but_pressed = true; // Exit from this if-condition, until the next but press
+// Button timers (awaits of the button ctx)
+typedef enum {
 
-            reboot_await(&button->MULTIPRESS_AWAIT, 1, TIME_UNIT_S); // Reboot the multipress await
-        }
-    }
-    
-    if (button->but_pressed && !but_level)
-    {
-        button->presses_counter += 1; // Increment the presses counter
-        button->but_pressed = false; // Set the permission for the next press
+    BUT_TIMER_DEBOUNCE,                 // DEBOUNCE_AWAIT
+    BUT_TIMER_MULTIPRESS,               // MULTIPRESS_AWAIT
+    BUT_TIMER_LONG_TIME,                // LONG_TIME_PRESS_AWAIT
 
-        end_await(&button->DEBOUNCE_AWAIT);
-        end_await(&button->MULTIPRESS_AWAIT);
-        end_await(&button->LONG_TIME_PRESS_AWAIT);
-    }
-    
-    // Start multipress await only if the presses counter > 0
-    if (button->presses_counter > 0 && button->mt_permission && !button->but_pressed)
-    {
-        async_await(&button->MULTIPRESS_AWAIT, 1, TIME_UNIT_S, true);
+} but_timer;
 
-        if (button->MULTIPRESS_AWAIT.end_flag)
-        {
-            if (button->presses_counter == presses_quantity)
-            {     
-                *flag = !*flag; // Reverse the flag if the timer ends up
-                button->presses_counter = 0;
-                end_await(&button->MULTIPRESS_AWAIT);
-            }
-            if (button->presses_counter > button->max_presses_quantity)
-            {     
-                button->presses_counter = 0;
-                end_await(&button->MULTIPRESS_AWAIT);
-            }
-        }
-    }
 
-    if (!button->mt_permission && button->long_time_await_end)
+static inline BUT_IRAM_ATTR async_await_ctx *but_timer_ctx(button_ctx *button, but_timer timer)
+{
+    switch (timer)
     {
-        button->presses_counter = 0;
-        end_await(&button->MULTIPRESS_AWAIT);
+#if BUTTON_CONTROL_MULTIPRESS
+        case BUT_TIMER_MULTIPRESS: return &button->MULTIPRESS_AWAIT;
+#endif
+#if BUTTON_CONTROL_LONG_PRESS
+        case BUT_TIMER_LONG_TIME: return &button->LONG_TIME_PRESS_AWAIT;
+#endif
+        default: return &button->DEBOUNCE_AWAIT;
     }
 }
 
-void flag_control_by_but_multiple_press(button_ctx *button, bool* flag, uint8_t presses_quantity)
-{
-    if (button->PIN == GPIO_NUM_NC || presses_quantity < 1)
-        return;
 
-    // Проверяем, подходит ли текущее количество нажатий под заданное условие
-    bool valid_press_count = false;
+// Timers of the compiled out features are not stored (constant for the inline calls)
+#define BUT_TIMER_STORED(timer) ((timer) == BUT_TIMER_DEBOUNCE ||                                  \
+                                 ((timer) == BUT_TIMER_MULTIPRESS && BUTTON_CONTROL_MULTIPRESS) ||  \
+                                 ((timer) == BUT_TIMER_LONG_TIME && BUTTON_CONTROL_LONG_PRESS))
 
-    if (presses_quantity == 1 && button->presses_counter <= 1)
-        valid_press_count = true;
 
-    else if (button->presses_counter == presses_quantity)
-        valid_press_count = true;
+#if BUTTON_CONTROL_WAKEUP
 
-    if (valid_press_count)
-        flag_control_by_but_multiple_press_inside(button, flag, presses_quantity);
+// Timer deadline for the button_next_wakeup_us (set once by the first await call)
+static inline void BUT_IRAM_ATTR but_timer_arm(button_ctx *button, but_timer timer, int64_t duration_us)
+{
+    if (button->timer_deadline_us[timer] == 0) button->timer_deadline_us[timer] = but_time_now() + duration_us;
 }
 
-// Switch the flag value by the long BUT press (flag holds the switched value, until the BUT pressed
-// once again)
-void flag_control_by_but_longtime_press(button_ctx *button, bool* flag)
+
+static inline void BUT_IRAM_ATTR but_timer_disarm(button_ctx *button, but_timer timer)
 {
-    // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
+    button->timer_deadline_us[timer] = 0;
+}
 
-    // No option to work for button with fixation
-    if (button->type == FIX) return;
+#else
 
+#define but_timer_arm(button, timer, duration_us) ((void)0)
+#define but_timer_disarm(button, timer) ((void)0)
 
-    // BUT state
-    int but_level = fast_but_gpio_read(button);
+#endif // BUTTON_CONTROL_WAKEUP
 
-    if (!button->but_long_pressed && but_level)
+
+#if BUTTON_CONTROL_SIM_INPUT
+
+// Await on the simulated clock with the async_await behavior: started by the first call, true after
+// the time (restart - the next call starts it again)
+static inline bool BUT_IRAM_ATTR but_sim_await(button_ctx *button, but_timer timer, int64_t duration_us, bool restart)
+{
+    int64_t now_us = simulated_time_source();
+    uint8_t bit = 1 << timer;
+
+    if (!(button->sim_timers_running & bit))
     {
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {   
-            button->but_long_pressed = true;
-        }
+        button->sim_timers_running |= bit;
+        button->sim_timer_start_us[timer] = now_us;
     }
-    // If we got the debounce flag and button still pressed
-    else if (button->but_long_pressed && but_level)
-    {   
-        button->one_time_block = false; // Reset the timers for longtime check
-        button->mt_permission = false; // Block the one time press logic
 
-        // Wait 3 seconds
-        if (async_await(&button->LONG_TIME_PRESS_AWAIT, 3, TIME_UNIT_S, false))
-        {
-            *flag = !*flag; // Flag switch
-            button->long_time_await_end = true;
-            button->one_time_block = true;
-        }
-    }
-    if (button->long_time_await_end && but_level)
-    {
-        button->but_long_pressed = false;
+    if (now_us - button->sim_timer_start_us[timer] < duration_us) return false;
 
-        end_await(&button->LONG_TIME_PRESS_AWAIT);
-        end_await(&button->DEBOUNCE_AWAIT);
-    }
+    if (restart) button->sim_timers_running &= ~bit;
 
-    // Reset for the next press if button was pressed and user don't hold the button no more.
-    if (button->long_time_await_end && !but_level)
-    {
-        button->mt_permission = false;
-        button->long_time_await_end = false;
-    }  
-    else if (!button->long_time_await_end && !but_level)
-    {
-        button->mt_permission = true;
-        button->long_time_await_end = false;
-    }  
+    return true;
 }
 
 
+// Await stop / restart on the simulated clock
+static inline void BUT_IRAM_ATTR but_sim_await_end(button_ctx *button, but_timer timer)
+{
+    button->sim_timers_running &= ~(1 << timer);
+}
 
-// Switch the flag value by the infinite BUT press (flag holds the switched value, until the BUT pressed, 
-// flag return to the first value if button ain't pressed no more)
-void flag_control_by_but_infinite_press(button_ctx *button, bool* flag)
+
+static inline void BUT_IRAM_ATTR but_sim_await_reboot(button_ctx *button, but_timer timer)
 {
+    button->sim_timers_running |= 1 << timer;
+    button->sim_timer_start_us[timer] = simulated_time_source();
+}
 
-    // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
+#endif // BUTTON_CONTROL_SIM_INPUT
 
-    // BUT state
-    int but_level = fast_but_gpio_read(button);
 
-    if (!button->but_pressed && but_level)
-    {
-        // Save the flag value
-        button->but_snapshot = *flag;
+// Debounce await (debounce section of the profiler)
+static inline bool BUT_IRAM_ATTR but_debounce_await(button_ctx *button)
+{
+    BUT_PROF_SECTION_BEGIN();
 
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {
-            *flag = !*flag; // Flag one time switch
-            button->but_pressed = true;
-            button->mt_permission = false;
-        }
-    }
-    // Reset for the next press if button was pressed and user don't hold the button no more.
-    else if (button->but_pressed && !but_level)
-    {
-        // Set the flag as the initial flag value
-        *flag = button->but_snapshot;
+    but_timer_arm(button, BUT_TIMER_DEBOUNCE, 3 * 1000);
 
-        // Reset the but_press state
-        button->but_pressed = false;
-        
-        // Stop await
-        end_await(&button->DEBOUNCE_AWAIT);
-    }  
+    bool debounce_end;
+
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_time_source != NULL) debounce_end = but_sim_await(button, BUT_TIMER_DEBOUNCE, 3 * 1000, false);
+    else
+#endif
+    debounce_end = async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false);
+
+    if (debounce_end) but_timer_disarm(button, BUT_TIMER_DEBOUNCE);
+
+    BUT_PROF_SECTION_END(BUT_PROF_SECTION_DEBOUNCE);
+
+    return debounce_end;
+}
+
+
+// Multipress / long-time press await in seconds (timers section of the profiler)
+static inline bool BUT_IRAM_ATTR but_timer_await(button_ctx *button, but_timer timer, unsigned int seconds, bool restart)
+{
+    BUT_PROF_SECTION_BEGIN();
+
+    but_timer_arm(button, timer, (int64_t)seconds * 1000000);
+
+    bool timer_end;
+
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_time_source != NULL) timer_end = but_sim_await(button, timer, (int64_t)seconds * 1000000, restart);
+    else
+#endif
+    timer_end = async_await(but_timer_ctx(button, timer), seconds, TIME_UNIT_S, restart);
+
+    if (timer_end) but_timer_disarm(button, timer);
+
+    BUT_PROF_SECTION_END(BUT_PROF_SECTION_TIMERS);
+
+    return timer_end;
+}
+
+
+// End flag of the await (the simulated clock awaits have no ctx flag - the await result is used)
+static inline bool BUT_IRAM_ATTR but_timer_end_flag(button_ctx *button, but_timer timer, bool await_result)
+{
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_time_source != NULL) return await_result;
+#else
+    (void)await_result;
+#endif
+
+    return but_timer_ctx(button, timer)->end_flag;
+}
+
+
+// Await stop
+static inline void BUT_IRAM_ATTR but_timer_end(button_ctx *button, but_timer timer)
+{
+    if (!BUT_TIMER_STORED(timer)) return;
+
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_time_source != NULL) but_sim_await_end(button, timer);
+    else
+#endif
+    end_await(but_timer_ctx(button, timer));
+
+    but_timer_disarm(button, timer);
+}
+
+
+// Await restart in seconds
+static inline void BUT_IRAM_ATTR but_timer_reboot(button_ctx *button, but_timer timer, unsigned int seconds)
+{
+#if BUTTON_CONTROL_SIM_INPUT
+    if (simulated_time_source != NULL) but_sim_await_reboot(button, timer);
+    else
+#endif
+    reboot_await(but_timer_ctx(button, timer), seconds, TIME_UNIT_S);
+
+    but_timer_disarm(button, timer);
+    but_timer_arm(button, timer, (int64_t)seconds * 1000000);
+}
+
+
+#if BUTTON_CONTROL_CALLBACKS
+
+// Callback performance with repeats (callback section of the profiler)
+static inline void BUT_IRAM_ATTR but_callback_perform(void (*callback)(void), unsigned int repeats)
+{
+    BUT_PROF_SECTION_BEGIN();
+
+    if (repeats != LOOP_PERFORMANCE)
+    {
+        for (unsigned int i = 0; i < repeats; i++)
+        {
+            callback();
+        }
+    }
+    else callback();
+
+    BUT_PROF_SECTION_END(BUT_PROF_SECTION_CALLBACK);
+}
+
+#endif // BUTTON_CONTROL_CALLBACKS
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Event listeners
+static BUT_DRAM_ATTR button_event_listener event_listeners[BUTTON_EVENT_LISTENERS_MAX];
+static BUT_DRAM_ATTR void *event_listeners_user[BUTTON_EVENT_LISTENERS_MAX];
+static BUT_DRAM_ATTR uint8_t event_listeners_quantity = 0;
+
+
+// Debounced press time for the hold duration
+static inline void BUT_IRAM_ATTR but_press_start(button_ctx *button)
+{
+    button->press_start_us = but_time_now();
+}
+
+
+// Event report to all listeners (callback section of the profiler)
+static void BUT_IRAM_ATTR but_event_emit(button_ctx *button, button_event_type type, uint8_t count)
+{
+    if (event_listeners_quantity == 0) return;
+
+    BUT_PROF_SECTION_BEGIN();
+
+    button_event event;
+
+    event.button = button;
+    event.PIN = button->PIN;
+    event.type = type;
+    event.count = count;
+    event.time_us = but_time_now();
+    event.hold_ms = (uint32_t)((event.time_us - button->press_start_us) / 1000);
+
+    for (uint8_t i = 0; i < event_listeners_quantity; i++)
+    {
+        event_listeners[i](&event, event_listeners_user[i]);
+    }
+
+    BUT_PROF_SECTION_END(BUT_PROF_SECTION_CALLBACK);
+}
+
+#else
+
+#define but_press_start(button) ((void)0)
+#define but_event_emit(button, type, count) ((void)0)
+
+#endif // BUTTON_CONTROL_EVENTS
+
+
+#if BUTTON_CONTROL_HEALTH
+
+// Hold duration bucket: < 128 ms, < 256 ms ... >= 8192 ms (shifts, no bounds table)
+static inline uint8_t BUT_IRAM_ATTR but_health_hold_bucket(uint32_t hold_ms)
+{
+    uint32_t scaled = hold_ms / BUTTON_HEALTH_HOLD_BUCKET_MS;
+    uint8_t bucket = 0;
+
+    while (scaled != 0 && bucket < BUTTON_HEALTH_HOLD_BUCKETS - 1)
+    {
+        scaled >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+
+// Settled level: one bounce / chatter sample for the statistics
+static void BUT_IRAM_ATTR but_health_settle(button_ctx *button)
+{
+    button_health *health = &button->health;
+    button_health_stats *stats = &health->stats;
+
+    health->edges = 0;
+
+    // Level came back - the pulse was rejected by the settle time
+    if (health->level == health->settled_level)
+    {
+        stats->chatter_rejected += 1;
+        return;
+    }
+
+    health->settled_level = health->level;
+
+    // Bounce: first edge -> last edge of the transition (0 for the clean edge)
+    uint32_t bounce_us = (uint32_t)(health->edge_last_us - health->edge_first_us);
+
+    stats->transitions += 1;
+    stats->bounce_total_us += bounce_us;
+
+    if (bounce_us > 0) stats->bounces += 1;
+    if (bounce_us > stats->bounce_max_us) stats->bounce_max_us = bounce_us;
+
+    // Recent average: 1/8 of the new value
+    stats->bounce_recent_us = (uint32_t)((int32_t)stats->bounce_recent_us +
+                                         ((int32_t)bounce_us - (int32_t)stats->bounce_recent_us) / 8);
+
+    if (health->level)
+    {
+        stats->presses += 1;
+        health->press_us = health->edge_first_us;
+    }
+    else if (health->press_us != 0)
+    {
+        stats->hold_histogram[but_health_hold_bucket((uint32_t)((health->edge_first_us - health->press_us) / 1000))] += 1;
+        health->press_us = 0;
+    }
+
+    // Degrading contact (reported once, hysteresis of 1/4 of the limit)
+    if (!stats->degrading && stats->bounce_recent_us > BUTTON_HEALTH_BOUNCE_LIMIT_US)
+    {
+        stats->degrading = true;
+        but_event_emit(button, BUTTON_EVENT_CONTACT_DEGRADING, 1);
+    }
+    else if (stats->degrading && stats->bounce_recent_us < BUTTON_HEALTH_BOUNCE_LIMIT_US * 3 / 4)
+    {
+        stats->degrading = false;
+    }
+}
+
+
+// Contact health update by every button sample (settled level - one compare)
+static inline void BUT_IRAM_ATTR but_health_sample(button_ctx *button, int but_level)
+{
+    button_health *health = &button->health;
+
+    // Edge: starts or continues the unsettled level
+    if ((bool)but_level != health->level)
+    {
+        int64_t now_us = but_time_now();
+
+        if (health->edges == 0) health->edge_first_us = now_us;
+
+        health->edge_last_us = now_us;
+        health->level = but_level;
+
+        if (health->edges < UINT8_MAX) health->edges += 1;
+
+        return;
+    }
+
+    if (health->edges == 0) return;
+
+    // Unsettled level without edges for the settle time
+    if (but_time_now() - health->edge_last_us >= BUTTON_HEALTH_SETTLE_US) but_health_settle(button);
+}
+
+#endif // BUTTON_CONTROL_HEALTH
+
+
+#if BUTTON_CONTROL_PUBLISH
+
+// Seqlock write section of the bank stats (single writer)
+static inline void BUT_IRAM_ATTR but_publish_stats_begin(button_publish_bank *bank)
+{
+    uint_least32_t sequence = atomic_load_explicit(&bank->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&bank->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);      // Odd sequence is visible before the stats writes
+}
+
+
+static inline void BUT_IRAM_ATTR but_publish_stats_end(button_publish_bank *bank)
+{
+    uint_least32_t sequence = atomic_load_explicit(&bank->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&bank->sequence, sequence + 1, memory_order_release);
+}
+
+
+// Flag publication after the flag write of the flag API
+static void BUT_IRAM_ATTR but_publish_flag(button_ctx *button, button_publish_flag flag, bool value)
+{
+    button_publish_bank *bank = button->publish_bank;
+
+    if (bank == NULL) return;
+
+    uint_least32_t bit = (uint_least32_t)1 << (button->publish_index * BUTTON_PUBLISH_FLAGS_QUANTITY + flag);
+
+    if (value) atomic_fetch_or_explicit(&bank->flags, bit, memory_order_release);
+    else atomic_fetch_and_explicit(&bank->flags, ~bit, memory_order_release);
+
+    but_publish_stats_begin(bank);
+
+    bank->stats.flag_changes[button->publish_index] += 1;
+    bank->stats.last_change_us = but_time_now();
+
+    but_publish_stats_end(bank);
+}
+
+
+#if BUTTON_CONTROL_MULTIPRESS
+
+// Presses counter publication after its change
+static void BUT_IRAM_ATTR but_publish_counter(button_ctx *button)
+{
+    button_publish_bank *bank = button->publish_bank;
+
+    if (bank == NULL) return;
+
+    but_publish_stats_begin(bank);
+
+    bank->stats.presses_counter[button->publish_index] = (uint8_t)button->presses_counter;
+    bank->stats.last_change_us = but_time_now();
+
+    but_publish_stats_end(bank);
+}
+
+#endif // BUTTON_CONTROL_MULTIPRESS
+
+#else
+
+#define but_publish_flag(button, flag, value) ((void)0)
+#endif // BUTTON_CONTROL_PUBLISH
+
+#if !BUTTON_CONTROL_PUBLISH || !BUTTON_CONTROL_MULTIPRESS
+#define but_publish_counter(button) ((void)0)
+#endif
+
+
+// State autofill of the button ctx (everything except the user data)
+static void but_state_reset(button_ctx *button)
+{
+    button->but_pressed = false;
+    button->but_long_pressed = false;
+    button->but_snapshot = false;
+
+    button->one_time_block = false;
+    button->mt_permission = true;
+
+    button->long_time_await_end = true;
+
+#if BUTTON_CONTROL_MULTIPRESS
+    button->presses_counter = 0;
+    button->max_presses_quantity = 1;
+#endif
+
+#if BUTTON_CONTROL_CALLBACKS
+    button->onetime_press_callback = NULL;
+
+#if BUTTON_CONTROL_MULTIPRESS
+    button->multiple_press_callback = NULL;
+#endif
+
+#if BUTTON_CONTROL_LONG_PRESS
+    button->long_time_press_callback = NULL;
+    button->long_time_press_permission = false;
+
+    button->infinite_press_callback = NULL;
+    button->infinite_press_permission = false;
+#endif
+#endif // BUTTON_CONTROL_CALLBACKS
+
+    // Awaits initialization
+    button->DEBOUNCE_AWAIT = async_await_ctx_default();
+
+#if BUTTON_CONTROL_MULTIPRESS
+    button->MULTIPRESS_AWAIT = async_await_ctx_default();
+#endif
+
+#if BUTTON_CONTROL_LONG_PRESS
+    button->LONG_TIME_PRESS_AWAIT = async_await_ctx_default();
+#endif
+
+#if BUTTON_CONTROL_SIM_INPUT
+    button->sim_timers_running = 0;
+#endif
+
+#if BUTTON_CONTROL_EVENTS
+    button->press_start_us = 0;
+#endif
+
+#if BUTTON_CONTROL_WAKEUP
+    button->timer_deadline_us[BUT_TIMER_DEBOUNCE] = 0;
+    button->timer_deadline_us[BUT_TIMER_MULTIPRESS] = 0;
+    button->timer_deadline_us[BUT_TIMER_LONG_TIME] = 0;
+#endif
+
+#if BUTTON_CONTROL_PROFILER
+    button_profiler_reset_button(button);
+#endif
+
+#if BUTTON_CONTROL_HEALTH
+    button_health_reset(button);
+#endif
+
+#if BUTTON_CONTROL_PUBLISH
+    button->publish_bank = NULL;
+    button->publish_index = 0;
+#endif
+}
+
+
+// User data check without prints (status code APIs)
+static inline bool but_config_valid(gpio_num_t PIN, gpio_pull_mode_t pull_mode, button_type type)
+{
+    if (PIN < 0 || PIN >= TOTAL_PINS || !GPIO_IS_VALID_GPIO(PIN)) return false;
+
+    if (pull_mode != GPIO_PULLUP_ONLY &&
+        pull_mode != GPIO_PULLDOWN_ONLY &&
+        pull_mode != GPIO_PULLUP_PULLDOWN &&
+        pull_mode != GPIO_FLOATING) return false;
+
+    return (type == NO_FIX || type == FIX);
+}
+
+
+// Pins configuration by masks: one gpio_config call per used pull mode
+static esp_err_t but_pins_config(const uint64_t pull_mode_masks[4])
+{
+    for (int pull_mode = 0; pull_mode < 4; pull_mode++)
+    {
+        if (pull_mode_masks[pull_mode] == 0) continue;
+
+        gpio_config_t config = {
+            .pin_bit_mask = pull_mode_masks[pull_mode],
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = (pull_mode == GPIO_PULLUP_ONLY || pull_mode == GPIO_PULLUP_PULLDOWN) ?
+                          GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+            .pull_down_en = (pull_mode == GPIO_PULLDOWN_ONLY || pull_mode == GPIO_PULLUP_PULLDOWN) ?
+                            GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+
+        esp_err_t error = gpio_config(&config);
+
+        if (error != ESP_OK) return error;
+    }
+
+    return ESP_OK;
+}
+
+
+#if BUTTON_CONTROL_ENCODER
+
+// AB levels of the encoder in the snapshot (A - bit 1, B - bit 0)
+static inline uint8_t BUT_IRAM_ATTR but_encoder_state(const button_encoder *encoder, const button_bank_snapshot *bank)
+{
+    return (uint8_t)((but_bank_level(bank->in, bank->in1, encoder->PIN_A) << 1) |
+                     but_bank_level(bank->in, bank->in1, encoder->PIN_B));
+}
+
+
+// Encoders decoding by the edges of the latched snapshot
+static void BUT_IRAM_ATTR but_encoders_decode(void)
+{
+    uint32_t edges = (bank_latched.in ^ encoders_previous.in) & encoders_mask.in;
+    uint32_t edges1 = (bank_latched.in1 ^ encoders_previous.in1) & encoders_mask.in1;
+
+    encoders_previous = bank_latched;
+
+    // No encoder pin has changed in this tick
+    if ((edges | edges1) == 0) return;
+
+    for (uint8_t i = 0; i < encoders_quantity; i++)
+    {
+        button_encoder *encoder = encoders[i];
+        uint8_t state = but_encoder_state(encoder, &bank_latched);
+
+        if (state == encoder->state) continue;
+
+        int8_t step = encoder_steps_table[(encoder->state << 2) | state];
+
+        encoder->state = state;
+
+        // Both channels changed: the step direction is lost
+        if (step == 0)
+        {
+            encoder->errors += 1;
+            continue;
+        }
+
+        encoder->steps += 1;
+        encoder->sub_steps += step;
+
+        if (encoder->sub_steps >= encoder->steps_per_detent)
+        {
+            encoder->sub_steps -= encoder->steps_per_detent;
+            encoder->position += 1;
+            encoder->delta += 1;
+        }
+        else if (encoder->sub_steps <= -encoder->steps_per_detent)
+        {
+            encoder->sub_steps += encoder->steps_per_detent;
+            encoder->position -= 1;
+            encoder->delta -= 1;
+        }
+    }
+}
+
+
+// Pins mask of all registered encoders
+static void but_encoders_mask_update(void)
+{
+    encoders_mask = (button_bank_snapshot){ 0 };
+
+    for (uint8_t i = 0; i < encoders_quantity; i++)
+    {
+        gpio_num_t pins[2] = { encoders[i]->PIN_A, encoders[i]->PIN_B };
+
+        for (int channel = 0; channel < 2; channel++)
+        {
+            if (pins[channel] < BUTTON_GPIO_LOW_BANK_PINS) encoders_mask.in |= 1UL << pins[channel];
+            else encoders_mask.in1 |= 1UL << (pins[channel] - BUTTON_GPIO_LOW_BANK_PINS);
+        }
+    }
+}
+
+#endif // BUTTON_CONTROL_ENCODER
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== API REALIZATION
+
+
+// Button constructor realization
+button_ctx button_initialization(gpio_num_t PIN, gpio_pull_mode_t pull_mode, button_type type)
+{
+#if BUTTON_CONTROL_VALIDATION
+    // Check the data - assert if it's wrong
+
+    // Pin number error handler
+    if (PIN < 0 || PIN >= TOTAL_PINS || !GPIO_IS_VALID_GPIO(PIN))
+    {
+        printf("Wrong pin number: %d (valid 0..%d)!\n", PIN, TOTAL_PINS - 1);
+        assert(0);
+    }
+
+    // GPIO regime error handler
+    if (pull_mode != GPIO_PULLUP_ONLY &&
+        pull_mode != GPIO_PULLDOWN_ONLY &&
+        pull_mode != GPIO_PULLUP_PULLDOWN &&
+        pull_mode != GPIO_FLOATING)
+    {
+        printf("You've chosen the wrong pull mode: %d\n", pull_mode);
+        assert(0);
+    }
+
+    // Button type error handler
+    if (type != NO_FIX && type != FIX)
+    {
+        printf("You've chosen the wrong button type: %d\n", type);
+        assert(0);
+    }
+#endif // BUTTON_CONTROL_VALIDATION
+
+
+    // Fill the struct with main user data
+    button_ctx new_button;
+
+    // First fill by user data
+    new_button.PIN = PIN;
+    new_button.pull_mode = pull_mode;
+    new_button.type = type;
+    new_button.detectors = BUTTON_DETECT_ALL;
+
+
+    gpio_set_direction(new_button.PIN, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(new_button.PIN, new_button.pull_mode);
+
+    
+    // First autofill of the other ctx data
+    but_state_reset(&new_button);
+
+    // Return the new button
+    return new_button; 
+}
+
+
+// In-place button constructor realization
+esp_err_t button_initialization_in_place(button_ctx *button, gpio_num_t PIN, gpio_pull_mode_t pull_mode, button_type type)
+{
+    button_config config = { PIN, pull_mode, type, BUTTON_DETECT_ALL };
+
+    return button_initialization_bulk(button, &config, 1);
+}
+
+
+// Bulk buttons constructor realization
+esp_err_t button_initialization_bulk(button_ctx buttons[], const button_config configs[], size_t quantity)
+{
+    // Error handler - check everything before any change
+    if (buttons == NULL || configs == NULL) return ESP_ERR_INVALID_ARG;
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        if (!but_config_valid(configs[i].PIN, configs[i].pull_mode, configs[i].type)) return ESP_ERR_INVALID_ARG;
+    }
+
+    uint64_t pull_mode_masks[4] = { 0 };
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        button_ctx *button = &buttons[i];
+
+        // First fill by user data
+        button->PIN = configs[i].PIN;
+        button->pull_mode = configs[i].pull_mode;
+        button->type = configs[i].type;
+        button->detectors = configs[i].detectors ? (configs[i].detectors & BUTTON_DETECT_ALL) : BUTTON_DETECT_ALL;
+
+        // Autofill of the other ctx data
+        but_state_reset(button);
+
+        pull_mode_masks[button->pull_mode] |= 1ULL << button->PIN;
+    }
+
+    return but_pins_config(pull_mode_masks);
+}
+
+
+
+// Button control APIs realization
+
+// Flags control
+
+// Switch the flag value by the short BUT press (flag holds the switched value, until the BUT pressed
+// once again)
+void BUT_IRAM_ATTR flag_control_by_but_onetime_press(button_ctx *button, bool* flag)
+{
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // No option to work for button with fixation
+    if (button->type == FIX) return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_ONETIME)) return;
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_FLAG_ONETIME);
+
+    // BUT state
+    int but_level = but_sample(button);
+
+    if (!button->but_pressed && but_level)
+    {
+        button->one_time_block = false; // Reset the timers for longtime check
+        
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {
+            button->but_pressed = true;
+            but_press_start(button);
+            button->mt_permission = true; // Reset by the press if earlier flag blocked by long time press
+        }
+    }
+    // Reset for the next press if but was pressed, mt_permission was obtained
+    // and user don't hold the button no more.
+    else if (button->but_pressed && button->mt_permission && !button->one_time_block && !but_level)
+    {
+        *flag = !*flag; // Change the flag
+        but_publish_flag(button, BUTTON_PUBLISH_ONETIME, *flag);
+        but_event_emit(button, BUTTON_EVENT_ONETIME_PRESS, 1);
+        but_timer_end(button, BUT_TIMER_DEBOUNCE); // Stop await
+        but_timer_end(button, BUT_TIMER_LONG_TIME);
+        
+        button->but_pressed = false; // Reset for the next call
+        button->one_time_block = true;
+    }
+
+    BUT_PROF_CALL_END(button);
+}
+
+
+#if BUTTON_CONTROL_MULTIPRESS
+
+// Switch the flag value by the several BUT presses (flag holds the switched value, until the BUT pressed
+// several times once again)
+void BUT_IRAM_ATTR flag_control_by_but_multiple_press_inside(button_ctx *button, bool* flag, uint8_t presses_quantity)
+{
+    // Logic error handler
+    if (presses_quantity < 1) return;
+
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // Update the maximum presses quantity value
+    if (presses_quantity > button->max_presses_quantity) button->max_presses_quantity = presses_quantity;
+
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_FLAG_MULTIPLE);
+
+    // BUT state read
+    int but_level = but_sample(button);
+
+    // One time press check
+    if (!button->but_pressed && but_level)
+    {
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {
+            button->mt_permission = true;
+
+            button->but_pressed = true; // Exit from this if-condition, until the next but press
+
+            but_timer_reboot(button, BUT_TIMER_MULTIPRESS, 1); // Reboot the multipress await
+        }
+    }
+    
+    if (button->but_pressed && !but_level)
+    {
+        button->presses_counter += 1; // Increment the presses counter
+        but_publish_counter(button);
+        button->but_pressed = false; // Set the permission for the next press
+
+        but_timer_end(button, BUT_TIMER_DEBOUNCE);
+        but_timer_end(button, BUT_TIMER_MULTIPRESS);
+        but_timer_end(button, BUT_TIMER_LONG_TIME);
+    }
+    
+    // Start multipress await only if the presses counter > 0
+    if (button->presses_counter > 0 && button->mt_permission && !button->but_pressed)
+    {
+        bool multipress_end = but_timer_await(button, BUT_TIMER_MULTIPRESS, 1, true);
+
+        if (but_timer_end_flag(button, BUT_TIMER_MULTIPRESS, multipress_end))
+        {
+            if (button->presses_counter == presses_quantity)
+            {     
+                *flag = !*flag; // Reverse the flag if the timer ends up
+                but_publish_flag(button, BUTTON_PUBLISH_MULTIPLE, *flag);
+                but_event_emit(button, BUTTON_EVENT_MULTIPLE_PRESS, presses_quantity);
+                button->presses_counter = 0;
+                but_publish_counter(button);
+                but_timer_end(button, BUT_TIMER_MULTIPRESS);
+            }
+            if (button->presses_counter > button->max_presses_quantity)
+            {     
+                button->presses_counter = 0;
+                but_publish_counter(button);
+                but_timer_end(button, BUT_TIMER_MULTIPRESS);
+            }
+        }
+    }
+
+    if (!button->mt_permission && button->long_time_await_end)
+    {
+        if (button->presses_counter > 0)
+        {
+            button->presses_counter = 0;
+            but_publish_counter(button);
+        }
+
+        but_timer_end(button, BUT_TIMER_MULTIPRESS);
+    }
+
+    BUT_PROF_CALL_END(button);
+}
+
+void BUT_IRAM_ATTR flag_control_by_but_multiple_press(button_ctx *button, bool* flag, uint8_t presses_quantity)
+{
+    if (button->PIN == GPIO_NUM_NC || presses_quantity < 1)
+        return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_MULTIPLE)) return;
+
+    // Проверяем, подходит ли текущее количество нажатий под заданное условие
+    bool valid_press_count = false;
+
+    if (presses_quantity == 1 && button->presses_counter <= 1)
+        valid_press_count = true;
+
+    else if (button->presses_counter == presses_quantity)
+        valid_press_count = true;
+
+    if (valid_press_count)
+        flag_control_by_but_multiple_press_inside(button, flag, presses_quantity);
+}
+
+#endif // BUTTON_CONTROL_MULTIPRESS
+
+
+#if BUTTON_CONTROL_LONG_PRESS
+
+// Switch the flag value by the long BUT press (flag holds the switched value, until the BUT pressed
+// once again)
+void BUT_IRAM_ATTR flag_control_by_but_longtime_press(button_ctx *button, bool* flag)
+{
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // No option to work for button with fixation
+    if (button->type == FIX) return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_LONGTIME)) return;
+
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_FLAG_LONGTIME);
+
+    // BUT state
+    int but_level = but_sample(button);
+
+    if (!button->but_long_pressed && but_level)
+    {
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {   
+            button->but_long_pressed = true;
+            but_press_start(button);
+        }
+    }
+    // If we got the debounce flag and button still pressed
+    else if (button->but_long_pressed && but_level)
+    {   
+        button->one_time_block = false; // Reset the timers for longtime check
+        button->mt_permission = false; // Block the one time press logic
+
+        // Wait 3 seconds
+        if (but_timer_await(button, BUT_TIMER_LONG_TIME, BUTTON_LONG_PRESS_S, false))
+        {
+            *flag = !*flag; // Flag switch
+            but_publish_flag(button, BUTTON_PUBLISH_LONGTIME, *flag);
+            but_event_emit(button, BUTTON_EVENT_LONG_PRESS, 1);
+            button->long_time_await_end = true;
+            button->one_time_block = true;
+        }
+    }
+    if (button->long_time_await_end && but_level)
+    {
+        button->but_long_pressed = false;
+
+        but_timer_end(button, BUT_TIMER_LONG_TIME);
+        but_timer_end(button, BUT_TIMER_DEBOUNCE);
+    }
+
+    // Reset for the next press if button was pressed and user don't hold the button no more.
+    if (button->long_time_await_end && !but_level)
+    {
+        button->mt_permission = false;
+        button->long_time_await_end = false;
+    }  
+    else if (!button->long_time_await_end && !but_level)
+    {
+        button->mt_permission = true;
+        button->long_time_await_end = false;
+    }
+
+    BUT_PROF_CALL_END(button);
+}
+
+#endif // BUTTON_CONTROL_LONG_PRESS
+
+
+
+// Switch the flag value by the infinite BUT press (flag holds the switched value, until the BUT pressed, 
+// flag return to the first value if button ain't pressed no more)
+void BUT_IRAM_ATTR flag_control_by_but_infinite_press(button_ctx *button, bool* flag)
+{
+
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_INFINITE)) return;
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_FLAG_INFINITE);
+
+    // BUT state
+    int but_level = but_sample(button);
+
+    if (!button->but_pressed && but_level)
+    {
+        // Save the flag value
+        button->but_snapshot = *flag;
+
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {
+            *flag = !*flag; // Flag one time switch
+            but_publish_flag(button, BUTTON_PUBLISH_INFINITE, *flag);
+            button->but_pressed = true;
+            button->mt_permission = false;
+            but_press_start(button);
+            but_event_emit(button, BUTTON_EVENT_INFINITE_PRESS_START, 1);
+        }
+    }
+    // Reset for the next press if button was pressed and user don't hold the button no more.
+    else if (button->but_pressed && !but_level)
+    {
+        // Set the flag as the initial flag value
+        *flag = button->but_snapshot;
+        but_publish_flag(button, BUTTON_PUBLISH_INFINITE, *flag);
+        but_event_emit(button, BUTTON_EVENT_INFINITE_PRESS_END, 1);
+
+        // Reset the but_press state
+        button->but_pressed = false;
+        
+        // Stop await
+        but_timer_end(button, BUT_TIMER_DEBOUNCE);
+    }
+
+    BUT_PROF_CALL_END(button);
+}
+
+
+#if BUTTON_CONTROL_CALLBACKS
+
+// Callbacks control
+// !!! NEED TO REBUILD LOGIC TO NEW VERSION LIKE IN THE FLAGS CONTROL !!!
+
+// Call the callback function by the short BUT press with specified repeats quantity 
+void BUT_IRAM_ATTR callback_control_by_but_onetime_press(button_ctx *button, unsigned int repeats)
+{
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_ONETIME)) return;
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_CALLBACK_ONETIME);
+
+    // BUT state
+    int but_level = but_sample(button);
+
+    if (!button->but_pressed && but_level)
+    {
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {
+            button->but_pressed = true;
+            but_press_start(button);
+            button->mt_permission = true; // Reset by the press if earlier flag blocked by long time press
+        }
+    }
+    // Reset for the next press if but was pressed, mt_permission was obtained
+    // and user don't hold the button no more.
+    else if (button->but_pressed && button->mt_permission && !but_level)
+    {
+        if (button->onetime_press_callback)
+        {
+            but_callback_perform(button->onetime_press_callback, repeats);
+        }
+
+        but_event_emit(button, BUTTON_EVENT_ONETIME_PRESS, 1);
+
+        but_timer_end(button, BUT_TIMER_DEBOUNCE); // Stop await
+        
+        button->but_pressed = false; // Reset for the next call
+    }
+
+    BUT_PROF_CALL_END(button);
 }
 
 
-// Callbacks control
-// !!! NEED TO REBUILD LOGIC TO NEW VERSION LIKE IN THE FLAGS CONTROL !!!
+#if BUTTON_CONTROL_MULTIPRESS
+
+// Call the callback function by the several BUT presses with specified repeats quantity
+void BUT_IRAM_ATTR callback_control_by_but_multiple_press(button_ctx *button, uint8_t presses_quantity, unsigned int repeats)
+{
+    // Logic error handler
+    if (presses_quantity < 1) return;
+
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_MULTIPLE)) return;
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_CALLBACK_MULTIPLE);
+
+    // BUT state
+    int but_level = but_sample(button);
+
+    // One time press check
+    if (!button->but_pressed && but_level)
+    {
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {
+            button->presses_counter += 1; // Increment the presses counter
+            but_publish_counter(button);
+            but_timer_reboot(button, BUT_TIMER_MULTIPRESS, 3); // Reboot the multipress await 
+            button->but_pressed = true; // Exit from this if-condition, until the next but press
+            button->mt_permission = true; // Reset by the press if earlier flag blocked by long time press
+        }
+    }
+    // Start multipress await only if the presses counter > 0
+    else if (button->presses_counter > 0)
+    {
+        if (but_timer_await(button, BUT_TIMER_MULTIPRESS, 3, true))
+        {
+            if (button->presses_counter == presses_quantity)
+            {
+                but_event_emit(button, BUTTON_EVENT_MULTIPLE_PRESS, presses_quantity);
+
+                if (button->multiple_press_callback)
+                {
+                    but_callback_perform(button->multiple_press_callback, repeats);
+                }
+            }
+    
+            // Reset the presses counter after MULTIPRESS_AWAIT ending
+            button->presses_counter = 0;
+            but_publish_counter(button);
+        }
+    }
+    // Reset for the next press if but was pressed, mt_permission was obtained
+    // and user don't hold the button no more.
+    else if (button->but_pressed && button->mt_permission && !but_level)
+    {
+        but_timer_end(button, BUT_TIMER_DEBOUNCE);
+        but_timer_end(button, BUT_TIMER_MULTIPRESS);
+
+        button->but_pressed = false; // Set the permission for the next press
+    }
+
+    BUT_PROF_CALL_END(button);
+} 
+
+#endif // BUTTON_CONTROL_MULTIPRESS
+
+
+#if BUTTON_CONTROL_LONG_PRESS
+
+// Calls the callback function by the long BUT press with specified repeats quantity
+void BUT_IRAM_ATTR callback_control_by_but_longtime_press(button_ctx *button, unsigned int repeats)
+{
+    // Error handler
+    if (button->PIN == GPIO_NUM_NC) return;
+
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_LONGTIME)) return;
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_CALLBACK_LONGTIME);
+
+    // BUT state
+    int but_level = but_sample(button);
+
+    if (!button->but_pressed && but_level)
+    {
+        // Flag switch after debounce
+        if (but_debounce_await(button))
+        {   
+            button->but_pressed = true;
+            but_press_start(button);
+        }
+    }
+    // If we got the debounce flag and button still pressed
+    else if (button->but_pressed && but_level)
+    {
+        // Wait 3 seconds
+        if (but_timer_await(button, BUT_TIMER_LONG_TIME, BUTTON_LONG_PRESS_S, false))
+        {
+            // One event per press (the await stays ended while the button is held)
+            if (!button->long_time_press_permission) but_event_emit(button, BUTTON_EVENT_LONG_PRESS, 1);
+
+            button->long_time_press_permission = true;
+            button->mt_permission = false; // Block the one time press logic
+        }
+    }
+    else if (button->long_time_press_permission)
+    {
+        if (button->long_time_press_callback)
+        {
+            but_callback_perform(button->long_time_press_callback, repeats);
+
+            if (repeats != LOOP_PERFORMANCE) button->long_time_press_permission = false;
+        }
+    }
+    // Reset for the next press if button was pressed and user don't hold the button no more.
+    else if (button->but_pressed && !but_level)
+    {
+        but_timer_end(button, BUT_TIMER_LONG_TIME);
+        but_timer_end(button, BUT_TIMER_DEBOUNCE);
+
+        button->but_pressed = false;
+    }
 
-// Call the callback function by the short BUT press with specified repeats quantity 
-void callback_control_by_but_onetime_press(button_ctx *button, unsigned int repeats)
+    BUT_PROF_CALL_END(button);
+}
+
+
+// Calls the callback function by the long BUT press with specified repeats quantity
+void BUT_IRAM_ATTR callback_control_by_but_infinite_press(button_ctx *button, unsigned int repeats)
 {
     // Error handler
     if (button->PIN == GPIO_NUM_NC) return;
 
+    // Disabled detector
+    if (!(button->detectors & BUTTON_DETECT_INFINITE)) return;
+
+    BUT_PROF_CALL_BEGIN(BUT_PROF_API_CALLBACK_INFINITE);
+
     // BUT state
-    int but_level = fast_but_gpio_read(button);
+    int but_level = but_sample(button);
 
     if (!button->but_pressed && but_level)
     {
         // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {
+        if (but_debounce_await(button))
+        {   
             button->but_pressed = true;
-            button->mt_permission = true; // Reset by the press if earlier flag blocked by long time press
+            but_press_start(button);
         }
     }
-    // Reset for the next press if but was pressed, mt_permission was obtained
-    // and user don't hold the button no more.
-    else if (button->but_pressed && button->mt_permission && !but_level)
+    // If we got the debounce flag and button still pressed
+    else if (button->but_pressed && but_level)
     {
-        if (button->onetime_press_callback)
+        // Wait 3 seconds
+        if (but_timer_await(button, BUT_TIMER_LONG_TIME, BUTTON_LONG_PRESS_S, false))
+        {
+            // One event per press (the await stays ended while the button is held)
+            if (!button->infinite_press_permission) but_event_emit(button, BUTTON_EVENT_INFINITE_PRESS_START, 1);
+
+            button->infinite_press_permission = true;
+            button->mt_permission = false; // Block the one time press logic
+        }
+    }
+    else if (button->infinite_press_permission && but_level)
+    {
+        if (button->infinite_press_callback)
+        {
+            but_callback_perform(button->infinite_press_callback, repeats);
+
+            if (repeats != LOOP_PERFORMANCE) button->infinite_press_permission = false;
+        }
+    }
+    // Reset for the next press if button was pressed and user don't hold the button no more.
+    else if (button->but_pressed && !but_level)
+    {
+        if (button->infinite_press_permission) but_event_emit(button, BUTTON_EVENT_INFINITE_PRESS_END, 1);
+
+        button->infinite_press_permission = false;
+
+        but_timer_end(button, BUT_TIMER_LONG_TIME);
+        but_timer_end(button, BUT_TIMER_DEBOUNCE);
+
+        button->but_pressed = false;
+    }
+
+    BUT_PROF_CALL_END(button);
+}
+
+#endif // BUTTON_CONTROL_LONG_PRESS
+
+#endif // BUTTON_CONTROL_CALLBACKS
+
+
+// Detectors mask set
+void button_detectors_set(button_ctx *button, uint8_t detectors)
+{
+    button->detectors = detectors & BUTTON_DETECT_ALL;
+}
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Event listeners control
+
+bool button_event_listener_add(button_event_listener listener, void *user)
+{
+    // Error handler
+    if (listener == NULL || event_listeners_quantity >= BUTTON_EVENT_LISTENERS_MAX) return false;
+
+    event_listeners[event_listeners_quantity] = listener;
+    event_listeners_user[event_listeners_quantity] = user;
+    event_listeners_quantity += 1;
+
+    return true;
+}
+
+
+void button_event_listener_remove(button_event_listener listener, void *user)
+{
+    for (uint8_t i = 0; i < event_listeners_quantity; i++)
+    {
+        if (event_listeners[i] == listener && event_listeners_user[i] == user)
         {
-            if (repeats != LOOP_PERFORMANCE)
+            // Shift the rest listeners
+            for (uint8_t j = i + 1; j < event_listeners_quantity; j++)
             {
-                for (unsigned int i = 0; i < repeats; i++)
-                {
-                    button->onetime_press_callback();
-                }               
+                event_listeners[j - 1] = event_listeners[j];
+                event_listeners_user[j - 1] = event_listeners_user[j];
             }
-            else button->onetime_press_callback();
+
+            event_listeners_quantity -= 1;
+            return;
         }
+    }
+}
+
+#endif // BUTTON_CONTROL_EVENTS
+
+
+#if BUTTON_CONTROL_WAKEUP
+
+// Next relevant moment of the button: now - poll needed, INT64_MAX - nothing until the level edge
+static int64_t but_wakeup_deadline(button_ctx *button, int64_t now_us)
+{
+#if BUTTON_CONTROL_LONG_PRESS && BUTTON_CONTROL_CALLBACKS
+    // Callbacks with the endless performance are called every poll
+    if (button->long_time_press_permission || button->infinite_press_permission) return now_us;
+#endif
+
+    int but_level = fast_but_gpio_read(button);
+    bool pressed = button->but_pressed || button->but_long_pressed;
+
+    int64_t deadline = INT64_MAX;
+    int64_t armed;
+
+    // Press under debounce (or not seen by the APIs yet)
+    if (but_level && !pressed)
+    {
+        armed = button->timer_deadline_us[BUT_TIMER_DEBOUNCE];
+        deadline = armed ? armed : now_us;
+    }
+#if BUTTON_CONTROL_LONG_PRESS
+    // Held press: long-time press await
+    else if (but_level && pressed)
+    {
+        armed = button->timer_deadline_us[BUT_TIMER_LONG_TIME];
+        if (armed) deadline = armed;
+    }
+#endif
+
+#if BUTTON_CONTROL_MULTIPRESS
+    // Multipress series end
+    if (button->presses_counter > 0)
+    {
+        armed = button->timer_deadline_us[BUT_TIMER_MULTIPRESS];
+        if (!armed) armed = now_us;
+        if (armed < deadline) deadline = armed;
+    }
+#endif
+
+#if BUTTON_CONTROL_HEALTH
+    // Unsettled level: the health sample must see it settled (or the chatter rejected)
+    if (button->health.edges != 0)
+    {
+        armed = button->health.edge_last_us + BUTTON_HEALTH_SETTLE_US;
+        if (armed < deadline) deadline = armed;
+    }
+#endif
+
+    return (deadline < now_us) ? now_us : deadline;
+}
+
+
+// Next wakeup for all the buttons
+int64_t button_next_wakeup_us(button_ctx *const buttons[], size_t quantity)
+{
+    int64_t now_us = but_time_now();
+    int64_t deadline = INT64_MAX;
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        int64_t button_deadline = but_wakeup_deadline(buttons[i], now_us);
+
+        if (button_deadline < deadline) deadline = button_deadline;
+
+        // Nothing can be earlier than now
+        if (deadline == now_us) return 0;
+    }
+
+    return (deadline == INT64_MAX) ? BUTTON_WAKEUP_ON_EDGE : deadline - now_us;
+}
+
+#endif // BUTTON_CONTROL_WAKEUP
+
+
+#if BUTTON_CONTROL_RETENTION
+
+// Deep sleep retention
+
+// FNV-1a checksum of the image (without the checksum field)
+static uint32_t but_state_image_checksum(const button_state_image *image)
+{
+    const uint8_t *data = (const uint8_t *)image;
+    uint32_t checksum = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(button_state_image, checksum); i++)
+    {
+        checksum = (checksum ^ data[i]) * 16777619u;
+    }
+
+    return checksum;
+}
+
+
+bool button_state_save(button_state_image *image, button_ctx *const buttons[], size_t quantity)
+{
+    // Error handler
+    if (quantity > BUTTON_STATE_IMAGE_MAX_BUTTONS) return false;
+
+    memset(image, 0, sizeof(*image));
+
+    image->magic = BUTTON_STATE_IMAGE_MAGIC;
+    image->quantity = (uint8_t)quantity;
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        const button_ctx *button = buttons[i];
+
+        image->buttons[i].PIN = (uint8_t)button->PIN;
+        image->buttons[i].config = ((uint8_t)button->pull_mode & 0x3) | ((button->type == FIX) << 2);
+#if BUTTON_CONTROL_MULTIPRESS
+        image->buttons[i].max_presses_quantity = button->max_presses_quantity;
+#else
+        image->buttons[i].max_presses_quantity = 1;
+#endif
+        image->buttons[i].detectors = button->detectors;
+    }
+
+    image->checksum = but_state_image_checksum(image);
+
+    return true;
+}
+
+
+bool button_state_restore(const button_state_image *image, button_ctx *const buttons[], size_t quantity)
+{
+    // Error handler (zeroed RTC memory after the power-on, other firmware image and so on)
+    bool image_v1 = (image->magic == BUTTON_STATE_IMAGE_MAGIC_V1);
+
+    if ((image->magic != BUTTON_STATE_IMAGE_MAGIC && !image_v1) || image->quantity != quantity) return false;
+    if (quantity > BUTTON_STATE_IMAGE_MAX_BUTTONS || image->checksum != but_state_image_checksum(image)) return false;
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        button_ctx *button = buttons[i];
+
+        button->PIN = (gpio_num_t)image->buttons[i].PIN;
+        button->pull_mode = (gpio_pull_mode_t)(image->buttons[i].config & 0x3);
+        button->type = (image->buttons[i].config & 0x4) ? FIX : NO_FIX;
+
+        // Mask as saved (a button with all detectors disabled stays disabled), 0 of the older images - all
+        button->detectors = image->buttons[i].detectors;
+
+        if (image_v1 && button->detectors == 0) button->detectors = BUTTON_DETECT_ALL;
+
+        but_state_reset(button);
+
+#if BUTTON_CONTROL_MULTIPRESS
+        button->max_presses_quantity = image->buttons[i].max_presses_quantity;
+#endif
+    }
+
+    return true;
+}
+
+
+bool button_state_resume(const button_state_image *image, button_ctx *const buttons[], size_t quantity,
+                         uint64_t wake_pins)
+{
+    if (!button_state_restore(image, buttons, quantity)) return false;
+
+    uint64_t pull_mode_masks[4] = { 0 };
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        pull_mode_masks[buttons[i]->pull_mode] |= 1ULL << buttons[i]->PIN;
+    }
+
+    if (but_pins_config(pull_mode_masks) != ESP_OK) return false;
+
+    for (size_t i = 0; i < quantity; i++)
+    {
+        button_ctx *button = buttons[i];
+
+        // Not a wakeup button
+        if (!((wake_pins >> button->PIN) & 0x1)) continue;
+
+        // The press started before the boot: no debounce, the long-time press await starts at the first poll
+        button->but_pressed = true;
+        button->mt_permission = true;
+        button->one_time_block = false;
+        button->long_time_await_end = false;
+
+        if (fast_but_gpio_read(button)) button->but_long_pressed = true;
+
+#if BUTTON_CONTROL_EVENTS
+        button->press_start_us = 0;
+#endif
+    }
+
+    return true;
+}
+
+#endif // BUTTON_CONTROL_RETENTION
+
+
+#if BUTTON_CONTROL_PUBLISH
+
+// Flags publication
+
+void button_publish_bank_init(button_publish_bank *bank)
+{
+    atomic_init(&bank->flags, 0);
+    atomic_init(&bank->sequence, 0);
+
+    memset(&bank->stats, 0, sizeof(bank->stats));
+}
+
+
+bool button_publish_attach(button_ctx *button, button_publish_bank *bank, uint8_t index)
+{
+    // Error handler
+    if (index >= BUTTON_PUBLISH_BANK_BUTTONS) return false;
+
+    button->publish_bank = bank;
+    button->publish_index = index;
+
+    return true;
+}
+
+
+uint32_t button_publish_flags_read(const button_publish_bank *bank)
+{
+    return (uint32_t)atomic_load_explicit(&bank->flags, memory_order_acquire);
+}
+
+
+bool button_publish_flag_get(const button_publish_bank *bank, uint8_t index, button_publish_flag flag)
+{
+    return (button_publish_flags_read(bank) >> (index * BUTTON_PUBLISH_FLAGS_QUANTITY + flag)) & 0x1;
+}
+
+
+void button_publish_stats_read(const button_publish_bank *bank, button_publish_stats *stats)
+{
+    uint_least32_t before;
+    uint_least32_t after;
+
+    do
+    {
+        before = atomic_load_explicit(&bank->sequence, memory_order_acquire);
+
+        *stats = bank->stats;
+
+        atomic_thread_fence(memory_order_acquire);      // Stats reads are done before the sequence check
+        after = atomic_load_explicit(&bank->sequence, memory_order_relaxed);
+    }
+    while ((before & 0x1) || before != after);
+}
+
+#endif // BUTTON_CONTROL_PUBLISH
+
+
+// Input bank read for the current tick
+BUT_IRAM_ATTR const button_bank_snapshot *button_bank_sample(void)
+{
+    but_bank_read(&bank_latched);
+
+    bank_latched_mode = true;
+
+#if BUTTON_CONTROL_ENCODER
+    if (encoders_quantity > 0) but_encoders_decode();
+#endif
+
+    return &bank_latched;
+}
+
+
+// Engine time
+int64_t BUT_IRAM_ATTR button_time_us(void)
+{
+    return but_time_now();
+}
+
+
+// Pressed level by the button settings
+bool BUT_IRAM_ATTR button_is_held(const button_ctx *button)
+{
+    return fast_but_gpio_read(button);
+}
+
+
+#if BUTTON_CONTROL_ENCODER
+
+// Encoder constructor realization
+esp_err_t button_encoder_initialization(button_encoder *encoder, gpio_num_t PIN_A, gpio_num_t PIN_B,
+                                        gpio_pull_mode_t pull_mode, uint8_t steps_per_detent)
+{
+    // Error handler
+    if (encoder == NULL || PIN_A == PIN_B) return ESP_ERR_INVALID_ARG;
+    if (!but_config_valid(PIN_A, pull_mode, NO_FIX) || !but_config_valid(PIN_B, pull_mode, NO_FIX)) return ESP_ERR_INVALID_ARG;
+    if (steps_per_detent != 1 && steps_per_detent != 2 && steps_per_detent != 4) return ESP_ERR_INVALID_ARG;
+
+    if (encoders_quantity >= BUTTON_ENCODERS_MAX) return ESP_ERR_NO_MEM;
+
+    uint64_t pull_mode_masks[4] = { 0 };
+
+    pull_mode_masks[pull_mode] = (1ULL << PIN_A) | (1ULL << PIN_B);
+
+    esp_err_t error = but_pins_config(pull_mode_masks);
+
+    if (error != ESP_OK) return error;
+
+    encoder->PIN_A = PIN_A;
+    encoder->PIN_B = PIN_B;
+    encoder->steps_per_detent = steps_per_detent;
+
+    encoder->sub_steps = 0;
+    encoder->position = 0;
+    encoder->delta = 0;
+    encoder->steps = 0;
+    encoder->errors = 0;
+
+    // Rest position: the current levels (the latched snapshot is not fresh before the first sample)
+    button_bank_snapshot bank;
+
+    but_bank_read(&bank);
+
+    encoder->state = but_encoder_state(encoder, &bank);
+
+    encoders[encoders_quantity++] = encoder;
+    but_encoders_mask_update();
+
+    // Edges of the new pins are counted from the rest levels: the latched snapshot can be older than the
+    // state, a stale level of A / B would make the first edge to be lost or invented
+    uint64_t pins = (1ULL << PIN_A) | (1ULL << PIN_B);
+
+    encoders_previous.in = (encoders_previous.in & ~(uint32_t)pins) | (bank.in & (uint32_t)pins);
+    encoders_previous.in1 = (encoders_previous.in1 & ~(uint32_t)(pins >> 32)) | (bank.in1 & (uint32_t)(pins >> 32));
+
+    return ESP_OK;
+}
+
+
+void button_encoder_remove(button_encoder *encoder)
+{
+    for (uint8_t i = 0; i < encoders_quantity; i++)
+    {
+        if (encoders[i] != encoder) continue;
+
+        // Keep the list dense
+        encoders[i] = encoders[encoders_quantity - 1];
+        encoders_quantity -= 1;
+
+        but_encoders_mask_update();
+        return;
+    }
+}
+
+
+int32_t button_encoder_delta_take(button_encoder *encoder)
+{
+    int32_t delta = encoder->delta;
+
+    encoder->delta = 0;
+
+    return delta;
+}
 
-        end_await(&button->DEBOUNCE_AWAIT); // Stop await
-        
-        button->but_pressed = false; // Reset for the next call
-    }
+#endif // BUTTON_CONTROL_ENCODER
+
+
+#if BUTTON_CONTROL_SIM_INPUT
+
+// Simulated input source set
+void button_input_source_set(button_input_source source)
+{
+    simulated_input_source = source;
 }
 
 
-// Call the callback function by the several BUT presses with specified repeats quantity
-void callback_control_by_but_multiple_press(button_ctx *button, uint8_t presses_quantity, unsigned int repeats)
+// Simulated bank source set
+void button_bank_source_set(button_bank_source source)
 {
-    // Logic error handler
-    if (presses_quantity < 1) return;
+    simulated_bank_source = source;
+}
 
-    // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
 
-    // BUT state
-    int but_level = fast_but_gpio_read(button);
+// Simulated time source set
+void button_time_source_set(button_time_source source)
+{
+    simulated_time_source = source;
+}
 
-    // One time press check
-    if (!button->but_pressed && but_level)
-    {
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {
-            button->presses_counter += 1; // Increment the presses counter
-            reboot_await(&button->MULTIPRESS_AWAIT, 3, TIME_UNIT_S); // Reboot the multipress await 
-            button->but_pressed = true; // Exit from this if-condition, until the next but press
-            button->mt_permission = true; // Reset by the press if earlier flag blocked by long time press
-        }
-    }
-    // Start multipress await only if the presses counter > 0
-    else if (button->presses_counter > 0)
-    {
-        if (async_await(&button->MULTIPRESS_AWAIT, 3, TIME_UNIT_S, true))
-        {
-            if (button->presses_counter == presses_quantity)
-            {
-                if (button->multiple_press_callback)
-                {
-                    if (repeats != LOOP_PERFORMANCE)
-                    {
-                        for (unsigned int i = 0; i < repeats; i++)
-                        {
-                            button->multiple_press_callback();
-                        }               
-                    }
-                    else button->multiple_press_callback();
-                }
-            }
-    
-            // Reset the presses counter after MULTIPRESS_AWAIT ending
-            button->presses_counter = 0;
-        }
-    }
-    // Reset for the next press if but was pressed, mt_permission was obtained
-    // and user don't hold the button no more.
-    else if (button->but_pressed && button->mt_permission && !but_level)
-    {
-        end_await(&button->DEBOUNCE_AWAIT);
-        end_await(&button->MULTIPRESS_AWAIT);
+#endif // BUTTON_CONTROL_SIM_INPUT
 
-        button->but_pressed = false; // Set the permission for the next press
-    }
-} 
 
+#if BUTTON_CONTROL_PROFILER
 
-// Calls the callback function by the long BUT press with specified repeats quantity
-void callback_control_by_but_longtime_press(button_ctx *button, unsigned int repeats)
+// Profiler APIs realization
+
+button_profiler_counter button_profiler_get(button_profiler_api api, button_profiler_section section)
 {
+    button_profiler_counter empty = { 0 };
+
     // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
+    if (api >= BUT_PROF_API_QUANTITY || section >= BUT_PROF_SECTION_QUANTITY) return empty;
 
-    // BUT state
-    int but_level = fast_but_gpio_read(button);
+    return profiler_table[api][section];
+}
 
-    if (!button->but_pressed && but_level)
-    {
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {   
-            button->but_pressed = true;
-        }
-    }
-    // If we got the debounce flag and button still pressed
-    else if (button->but_pressed && but_level)
-    {
-        // Wait 3 seconds
-        if (async_await(&button->LONG_TIME_PRESS_AWAIT, 3, TIME_UNIT_S, false))
-        {
-            button->long_time_press_permission = true;
-            button->mt_permission = false; // Block the one time press logic
-        }
-    }
-    else if (button->long_time_press_permission)
+
+uint32_t button_profiler_average(const button_profiler_counter *counter)
+{
+    if (counter->calls == 0) return 0;
+
+    return (uint32_t)(counter->total_cycles / counter->calls);
+}
+
+
+void button_profiler_reset(void)
+{
+    for (int api = 0; api < BUT_PROF_API_QUANTITY; api++)
     {
-        if (button->long_time_press_callback)
+        for (int section = 0; section < BUT_PROF_SECTION_QUANTITY; section++)
         {
-            if (repeats != LOOP_PERFORMANCE)
-            {
-                for (unsigned int i = 0; i < repeats; i++)
-                {
-                    button->long_time_press_callback();
-                }     
-                
-                button->long_time_press_permission = false;
-            }
-            else button->long_time_press_callback();
+            profiler_table[api][section] = (button_profiler_counter){ 0 };
         }
     }
-    // Reset for the next press if button was pressed and user don't hold the button no more.
-    else if (button->but_pressed && !but_level)
-    {
-        end_await(&button->LONG_TIME_PRESS_AWAIT);
-        end_await(&button->DEBOUNCE_AWAIT);
+}
 
-        button->but_pressed = false;
-    }  
+
+void button_profiler_reset_button(button_ctx *button)
+{
+    button->profiler = (button_profiler_counter){ 0 };
 }
 
 
-// Calls the callback function by the long BUT press with specified repeats quantity
-void callback_control_by_but_infinite_press(button_ctx *button, unsigned int repeats)
+void button_profiler_print(void)
 {
-    // Error handler
-    if (button->PIN == GPIO_NUM_NC) return;
+    static const char *api_names[BUT_PROF_API_QUANTITY] = {
+        "flag_onetime", "flag_multiple", "flag_longtime", "flag_infinite",
+        "callback_onetime", "callback_multiple", "callback_longtime", "callback_infinite"
+    };
 
-    // BUT state
-    int but_level = fast_but_gpio_read(button);
+    static const char *section_names[BUT_PROF_SECTION_QUANTITY] = {
+        "sample", "debounce", "timers", "state_machine", "callback", "total"
+    };
 
-    if (!button->but_pressed && but_level)
-    {
-        // Flag switch after debounce
-        if (async_await(&button->DEBOUNCE_AWAIT, 3, TIME_UNIT_MS, false))
-        {   
-            button->but_pressed = true;
-        }
-    }
-    // If we got the debounce flag and button still pressed
-    else if (button->but_pressed && but_level)
+    for (int api = 0; api < BUT_PROF_API_QUANTITY; api++)
     {
-        // Wait 3 seconds
-        if (async_await(&button->LONG_TIME_PRESS_AWAIT, 3, TIME_UNIT_S, false))
+        // Skip the APIs without calls
+        if (profiler_table[api][BUT_PROF_SECTION_TOTAL].calls == 0) continue;
+
+        printf("%s (%u calls):\n", api_names[api], (unsigned)profiler_table[api][BUT_PROF_SECTION_TOTAL].calls);
+
+        for (int section = 0; section < BUT_PROF_SECTION_QUANTITY; section++)
         {
-            button->infinite_press_permission = true;
-            button->mt_permission = false; // Block the one time press logic
+            const button_profiler_counter *counter = &profiler_table[api][section];
+
+            if (counter->calls == 0) continue;
+
+            printf("  %-14s min %6u  avg %6u  max %6u cycles\n", section_names[section],
+                   (unsigned)counter->min_cycles, (unsigned)button_profiler_average(counter),
+                   (unsigned)counter->max_cycles);
         }
     }
-    else if (button->infinite_press_permission && but_level)
+}
+
+#endif // BUTTON_CONTROL_PROFILER
+
+
+#if BUTTON_CONTROL_HEALTH
+
+// Contact health APIs realization
+
+void button_health_snapshot(button_ctx *const buttons[], size_t quantity, button_health_report reports[])
+{
+    for (size_t i = 0; i < quantity; i++)
     {
-        if (button->infinite_press_callback)
-        {
-            if (repeats != LOOP_PERFORMANCE)
-            {
-                for (unsigned int i = 0; i < repeats; i++)
-                {
-                    button->infinite_press_callback();
-                }     
-                
-                button->infinite_press_permission = false;
-            }
-            else button->infinite_press_callback();
-        }
+        const button_health_stats *stats = &buttons[i]->health.stats;
+
+        reports[i].PIN = buttons[i]->PIN;
+        reports[i].bounce_mean_us = (stats->transitions == 0) ? 0 :
+                                    (uint32_t)(stats->bounce_total_us / stats->transitions);
+        reports[i].stats = *stats;
     }
-    // Reset for the next press if button was pressed and user don't hold the button no more.
-    else if (button->but_pressed && !but_level)
-    {
-        button->infinite_press_permission = false;
+}
 
-        end_await(&button->LONG_TIME_PRESS_AWAIT);
-        end_await(&button->DEBOUNCE_AWAIT);
 
-        button->but_pressed = false;
-    }  
+void button_health_reset(button_ctx *button)
+{
+    button->health = (button_health){ 0 };
 }
 
+#endif // BUTTON_CONTROL_HEALTH
+
 
 // =========================================================================================== API REALIZATION
 
@@ -825,4 +2272,257 @@ void update_display_but_longtime()
 
 // =========================================================================================== LED CONTROL BY BUTTON PRESSES
 
+// =========================================================================================== DEEP SLEEP RESUME
+
+/*
+
+#include "esp_sleep.h"
+#include "esp_attr.h"
+
+#define MY_BUT_WAKE GPIO_NUM_33
+
+RTC_DATA_ATTR static button_state_image rtc_button_image;     // Survives the deep sleep
+
+button_ctx my_but_1;
+button_ctx *my_buttons[] = { &my_but_1 };
+
+static button_publish_bank panel_bank;
+
+void initialization()
+{
+    // Wakeup press is taken at once (no debounce, short / long is decided by the first polls)
+    if (!button_state_resume(&rtc_button_image, my_buttons, 1, esp_sleep_get_ext1_wakeup_status()))
+    {
+        // Power-on: ordinary initialization
+        my_but_1 = button_initialization(MY_BUT_WAKE, GPIO_PULLUP_ONLY, NO_FIX);
+    }
+
+    // Callbacks and publish links are not in the image: set them again after the resume too
+    my_but_1.onetime_press_callback = show_menu;
+
+    button_publish_bank_init(&panel_bank);
+    button_publish_attach(&my_but_1, &panel_bank, 0);
+}
+
+void go_to_sleep()
+{
+    button_state_save(&rtc_button_image, my_buttons, 1);
+
+    esp_sleep_enable_ext1_wakeup(1ULL << MY_BUT_WAKE, ESP_EXT1_WAKEUP_ALL_LOW);
+    esp_deep_sleep_start();
+}
+
+*/
+
+// =========================================================================================== DEEP SLEEP RESUME
+
+// =========================================================================================== CONTACT HEALTH
+
+/*
+
+button_ctx my_but_1;
+button_ctx my_but_2;
+button_ctx *my_buttons[] = { &my_but_1, &my_but_2 };
+
+// Degrading contact - plan the switch replacement before the customer complains
+static void health_listener(const button_event *event, void *user)
+{
+    if (event->type == BUTTON_EVENT_CONTACT_DEGRADING) printf("Pin %d: contact is degrading\n", event->PIN);
+}
+
+void initialization()
+{
+    my_but_1 = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    my_but_2 = button_initialization(GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX);
+
+    button_event_listener_add(health_listener, NULL);
+}
+
+// Once an hour (from the task of the button APIs)
+void health_report()
+{
+    button_health_report reports[2];
+
+    button_health_snapshot(my_buttons, 2, reports);
+
+    for (int i = 0; i < 2; i++)
+    {
+        printf("pin %d: presses %u, bounce mean %u us / max %u us, chatter %u, holds >= 1 s %u\n",
+               reports[i].PIN, (unsigned)reports[i].stats.presses,
+               (unsigned)reports[i].bounce_mean_us, (unsigned)reports[i].stats.bounce_max_us,
+               (unsigned)reports[i].stats.chatter_rejected,
+               (unsigned)(reports[i].stats.hold_histogram[4] + reports[i].stats.hold_histogram[5] +
+                          reports[i].stats.hold_histogram[6] + reports[i].stats.hold_histogram[7]));
+    }
+}
+
+// After the switch replacement
+button_health_reset(&my_but_1);
+
+*/
+
+// =========================================================================================== CONTACT HEALTH
+
+// =========================================================================================== IRAM POLL PATH
+
+/*
+
+// Buttons keep working during OTA / NVS writes: build with BUTTON_CONTROL_IRAM 1 and
+// CONFIG_GPTIMER_ISR_IRAM_SAFE=y, put the async_await lib into IRAM by its linker fragment:
+//
+//   [mapping:async_await]
+//   archive: libasync_await.a
+//   entries:
+//       * (noflash)
+
+#include "driver/gptimer.h"
+
+static DRAM_ATTR button_ctx my_but_1;          // Internal RAM
+static volatile bool menu_flag = false;
+
+// 1 ms poll from the IRAM-safe timer ISR (runs with the disabled flash cache)
+static bool IRAM_ATTR buttons_poll_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *user)
+{
+    button_bank_sample();
+    flag_control_by_but_onetime_press(&my_but_1, (bool *)&menu_flag);
+
+    return false;
+}
+
+void initialization()
+{
+    my_but_1 = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+
+    gptimer_handle_t timer;
+    gptimer_config_t timer_config = { .clk_src = GPTIMER_CLK_SRC_DEFAULT, .direction = GPTIMER_COUNT_UP,
+                                      .resolution_hz = 1000000 };
+    gptimer_event_callbacks_t callbacks = { .on_alarm = buttons_poll_isr };
+    gptimer_alarm_config_t alarm = { .alarm_count = 1000, .reload_count = 0, .flags.auto_reload_on_alarm = true };
+
+    gptimer_new_timer(&timer_config, &timer);
+    gptimer_register_event_callbacks(timer, &callbacks, NULL);
+    gptimer_set_alarm_action(timer, &alarm);
+    gptimer_enable(timer);
+    gptimer_start(timer);
+}
+
+// Worst-case cycles of this path under the flash writes - button_bench_flash_stall
+
+*/
+
+// =========================================================================================== IRAM POLL PATH
+
+// =========================================================================================== ENCODER
+
+/*
+
+// Rotary encoder with the push-button: A / B are decoded from the same bank snapshot as the buttons,
+// the push-button is an ordinary button ctx
+
+static button_encoder volume;
+static int32_t volume_level = 0;
+static bool volume_mute = false;
+
+void initialization()
+{
+    my_but_1 = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);     // Encoder push-button
+
+    button_encoder_initialization(&volume, GPIO_NUM_18, GPIO_NUM_19, GPIO_PULLUP_ONLY, 4);
+}
+
+void buttons_task(void *arg)
+{
+    while (1)
+    {
+        button_bank_sample();                                   // One registers read per pass: buttons + encoders
+
+        volume_level += button_encoder_delta_take(&volume);     // Detents since the last pass (+ CW / - CCW)
+
+        flag_control_by_but_onetime_press(&my_but_1, &volume_mute);
+
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+// Every pass must see each step state: max rate ~ (1 - phase error) steps per pass - button_bench_encoder
+// volume.errors counts the skipped states (too slow passes / too fast rotation)
+
+*/
+
+// =========================================================================================== ENCODER
+
+// =========================================================================================== FEATURE SELECTION
+
+/*
+
+// Only the one-time press flags on FIX / NO_FIX buttons: idf.py menuconfig -> Button control, or
+// sdkconfig.defaults of the project:
+//
+//   # CONFIG_BUTTON_CONTROL_CALLBACKS is not set
+//   # CONFIG_BUTTON_CONTROL_MULTIPRESS is not set
+//   # CONFIG_BUTTON_CONTROL_LONG_PRESS is not set
+//   CONFIG_BUTTON_CONTROL_ACTIVE_LOW=y
+//   # CONFIG_BUTTON_CONTROL_WAKEUP is not set
+//   # CONFIG_BUTTON_CONTROL_RETENTION is not set
+//   # CONFIG_BUTTON_CONTROL_PUBLISH is not set
+//   # CONFIG_BUTTON_CONTROL_VALIDATION is not set
+//   # CONFIG_BUTTON_CONTROL_EVENTS is not set
+//   # CONFIG_BUTTON_CONTROL_HEALTH is not set
+//   # CONFIG_BUTTON_CONTROL_ENCODER is not set
+//
+// Without the ESP-IDF menu - the same by the defines (-D or before the include):
+//
+//   -DBUTTON_CONTROL_CALLBACKS=0 -DBUTTON_CONTROL_MULTIPRESS=0 -DBUTTON_CONTROL_LONG_PRESS=0 ...
+//
+// Disabled features leave no code / data / ctx fields - ctx size of the own config: tools/button_size_report.py.
+// The button_control_task / event_log / coro modules need the events, the bench needs the simulated input.
+
+void initialization()
+{
+    my_but_1 = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    my_but_2 = button_initialization(GPIO_NUM_5, GPIO_PULLUP_ONLY, FIX);
+}
+
+flag_control_by_but_onetime_press(&my_but_1, &but_1_onetime_press);
+flag_control_by_but_onetime_press(&my_but_2, &but_2_onetime_press);
+
+*/
+
+// =========================================================================================== FEATURE SELECTION
+
+// =========================================================================================== FLAGS PUBLICATION
+
+/*
+
+// Buttons are polled by one task, the flags are read by the others without mutexes
+
+static button_publish_bank panel_bank;
+
+void initialization()
+{
+    my_but_1 = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    my_but_2 = button_initialization(GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX);
+
+    button_publish_bank_init(&panel_bank);
+    button_publish_attach(&my_but_1, &panel_bank, 0);
+    button_publish_attach(&my_but_2, &panel_bank, 1);
+}
+
+// Buttons task
+flag_control_by_but_onetime_press(&my_but_1, &but_1_onetime_press);
+flag_control_by_but_longtime_press(&my_but_2, &but_2_longtime_press);
+
+// Any other task / core: one atomic load for all the flags
+uint32_t flags = button_publish_flags_read(&panel_bank);
+
+if (button_publish_flag_get(&panel_bank, 0, BUTTON_PUBLISH_ONETIME)) { ... }
+
+// Consistent counters snapshot (never blocks the buttons task)
+button_publish_stats stats;
+button_publish_stats_read(&panel_bank, &stats);
+
+*/
+
+// =========================================================================================== FLAGS PUBLICATION
+
 // =========================================================================================== USING EXAMPLES SECTION
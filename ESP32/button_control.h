@@ -22,13 +22,16 @@
 // =========================================================================================== IMPORT
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "sdkconfig.h"                          // For the target chip - CONFIG_IDF_TARGET_*
+#include "esp_err.h"                            // For status codes - esp_err_t
 #include "driver/gpio.h"                        // For PIN enum types - gpio_num_t 
 #include "hal/gpio_types.h"                     // For PIN pull mode enum types - gpio_pull_mode_t  
 
 // For low-code read operation
-#include "soc/gpio_reg.h" 
-#include "soc/gpio_struct.h"
+#include "soc/gpio_reg.h"                       // For GPIO_IN_REG / GPIO_IN1_REG and REG_READ
 
 #include <my_libs/async_await/async_await.h>    // Async await lib connection
 
@@ -38,11 +41,336 @@
 // =========================================================================================== DEFINES
 
 #define LOOP_PERFORMANCE ((unsigned int)-1)     // Define for easy infinite callbacks performance 
-#define TOTAL_PINS 35                           // Total GPIOs quantity on your board
+
+// Input registers layout of the target chip (selected at the build time):
+//
+//   chip       GPIOs      GPIO_IN_REG     GPIO_IN1_REG
+//   ESP32      0..39      0..31           32..39
+//   ESP32-S2   0..46      0..31           32..46
+//   ESP32-S3   0..48      0..31           32..48
+//   ESP32-C3   0..21      0..21           -
+//   ESP32-C6   0..30      0..30           -
+//
+// Chips without the high bank never read GPIO_IN1_REG (snapshot in1 stays 0).
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    #define TOTAL_PINS 40                       // Total GPIOs quantity of the chip
+    #define BUTTON_GPIO_HIGH_BANK 1             // GPIO 32.. are read from GPIO_IN1_REG
+#elif defined(CONFIG_IDF_TARGET_ESP32S2)
+    #define TOTAL_PINS 47
+    #define BUTTON_GPIO_HIGH_BANK 1
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    #define TOTAL_PINS 49
+    #define BUTTON_GPIO_HIGH_BANK 1
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+    #define TOTAL_PINS 22
+    #define BUTTON_GPIO_HIGH_BANK 0
+#elif defined(CONFIG_IDF_TARGET_ESP32C6)
+    #define TOTAL_PINS 31
+    #define BUTTON_GPIO_HIGH_BANK 0
+#else
+    #error "button_control: unknown target chip, add its input registers layout"
+#endif
+
+#define BUTTON_GPIO_LOW_BANK_PINS 32            // Pins of the GPIO_IN_REG word
+
+// ESP-IDF Kconfig: the "Button control" menu of the menuconfig (ESP32/Kconfig) selects the features below.
+// Disabled Kconfig bools are not defined at all, so the options are mapped only if the menu is in the
+// build (CONFIG_BUTTON_CONTROL_KCONFIG). Defines passed by -D / before the include override the menu.
+#ifdef CONFIG_BUTTON_CONTROL_KCONFIG
+
+    #ifndef BUTTON_CONTROL_CALLBACKS
+        #ifdef CONFIG_BUTTON_CONTROL_CALLBACKS
+            #define BUTTON_CONTROL_CALLBACKS 1
+        #else
+            #define BUTTON_CONTROL_CALLBACKS 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_MULTIPRESS
+        #ifdef CONFIG_BUTTON_CONTROL_MULTIPRESS
+            #define BUTTON_CONTROL_MULTIPRESS 1
+        #else
+            #define BUTTON_CONTROL_MULTIPRESS 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_LONG_PRESS
+        #ifdef CONFIG_BUTTON_CONTROL_LONG_PRESS
+            #define BUTTON_CONTROL_LONG_PRESS 1
+        #else
+            #define BUTTON_CONTROL_LONG_PRESS 0
+        #endif
+    #endif
+
+    #if !defined(BUTTON_LONG_PRESS_S) && defined(CONFIG_BUTTON_CONTROL_LONG_PRESS_S)
+        #define BUTTON_LONG_PRESS_S CONFIG_BUTTON_CONTROL_LONG_PRESS_S
+    #endif
+
+    #ifndef BUTTON_CONTROL_ACTIVE_LEVEL
+        #if defined(CONFIG_BUTTON_CONTROL_ACTIVE_LOW)
+            #define BUTTON_CONTROL_ACTIVE_LEVEL BUTTON_ACTIVE_LOW
+        #elif defined(CONFIG_BUTTON_CONTROL_ACTIVE_HIGH)
+            #define BUTTON_CONTROL_ACTIVE_LEVEL BUTTON_ACTIVE_HIGH
+        #else
+            #define BUTTON_CONTROL_ACTIVE_LEVEL BUTTON_ACTIVE_BY_PULL_MODE
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_VALIDATION
+        #ifdef CONFIG_BUTTON_CONTROL_VALIDATION
+            #define BUTTON_CONTROL_VALIDATION 1
+        #else
+            #define BUTTON_CONTROL_VALIDATION 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_PROFILER
+        #ifdef CONFIG_BUTTON_CONTROL_PROFILER
+            #define BUTTON_CONTROL_PROFILER 1
+        #else
+            #define BUTTON_CONTROL_PROFILER 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_EVENTS
+        #ifdef CONFIG_BUTTON_CONTROL_EVENTS
+            #define BUTTON_CONTROL_EVENTS 1
+        #else
+            #define BUTTON_CONTROL_EVENTS 0
+        #endif
+    #endif
+
+    #if !defined(BUTTON_EVENT_LISTENERS_MAX) && defined(CONFIG_BUTTON_CONTROL_EVENT_LISTENERS_MAX)
+        #define BUTTON_EVENT_LISTENERS_MAX CONFIG_BUTTON_CONTROL_EVENT_LISTENERS_MAX
+    #endif
+
+    #ifndef BUTTON_CONTROL_HEALTH
+        #ifdef CONFIG_BUTTON_CONTROL_HEALTH
+            #define BUTTON_CONTROL_HEALTH 1
+        #else
+            #define BUTTON_CONTROL_HEALTH 0
+        #endif
+    #endif
+
+    #if !defined(BUTTON_HEALTH_BOUNCE_LIMIT_US) && defined(CONFIG_BUTTON_CONTROL_HEALTH_BOUNCE_LIMIT_US)
+        #define BUTTON_HEALTH_BOUNCE_LIMIT_US CONFIG_BUTTON_CONTROL_HEALTH_BOUNCE_LIMIT_US
+    #endif
+
+    #ifndef BUTTON_CONTROL_WAKEUP
+        #ifdef CONFIG_BUTTON_CONTROL_WAKEUP
+            #define BUTTON_CONTROL_WAKEUP 1
+        #else
+            #define BUTTON_CONTROL_WAKEUP 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_RETENTION
+        #ifdef CONFIG_BUTTON_CONTROL_RETENTION
+            #define BUTTON_CONTROL_RETENTION 1
+        #else
+            #define BUTTON_CONTROL_RETENTION 0
+        #endif
+    #endif
+
+    #if !defined(BUTTON_STATE_IMAGE_MAX_BUTTONS) && defined(CONFIG_BUTTON_CONTROL_STATE_IMAGE_MAX_BUTTONS)
+        #define BUTTON_STATE_IMAGE_MAX_BUTTONS CONFIG_BUTTON_CONTROL_STATE_IMAGE_MAX_BUTTONS
+    #endif
+
+    #ifndef BUTTON_CONTROL_PUBLISH
+        #ifdef CONFIG_BUTTON_CONTROL_PUBLISH
+            #define BUTTON_CONTROL_PUBLISH 1
+        #else
+            #define BUTTON_CONTROL_PUBLISH 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_ENCODER
+        #ifdef CONFIG_BUTTON_CONTROL_ENCODER
+            #define BUTTON_CONTROL_ENCODER 1
+        #else
+            #define BUTTON_CONTROL_ENCODER 0
+        #endif
+    #endif
+
+    #if !defined(BUTTON_ENCODERS_MAX) && defined(CONFIG_BUTTON_CONTROL_ENCODERS_MAX)
+        #define BUTTON_ENCODERS_MAX CONFIG_BUTTON_CONTROL_ENCODERS_MAX
+    #endif
+
+    #ifndef BUTTON_CONTROL_SIM_INPUT
+        #ifdef CONFIG_BUTTON_CONTROL_SIM_INPUT
+            #define BUTTON_CONTROL_SIM_INPUT 1
+        #else
+            #define BUTTON_CONTROL_SIM_INPUT 0
+        #endif
+    #endif
+
+    #ifndef BUTTON_CONTROL_IRAM
+        #ifdef CONFIG_BUTTON_CONTROL_IRAM
+            #define BUTTON_CONTROL_IRAM 1
+        #else
+            #define BUTTON_CONTROL_IRAM 0
+        #endif
+    #endif
+
+#endif // CONFIG_BUTTON_CONTROL_KCONFIG
+
+// Object size of the feature configurations on the target: tools/button_size_report.py (project build flags)
+
+// Callback APIs: 1 - callback_control_by_but_* APIs with the callback pointers in the button ctx,
+// 0 - compiled out completely (flag APIs only)
+#ifndef BUTTON_CONTROL_CALLBACKS
+    #define BUTTON_CONTROL_CALLBACKS 1
+#endif
+
+// Long-time press duration (seconds) of the long-time / infinite press APIs
+#ifndef BUTTON_LONG_PRESS_S
+    #define BUTTON_LONG_PRESS_S 3
+#endif
+
+// Active level of the buttons: BUTTON_ACTIVE_BY_PULL_MODE - by the pull mode of every button (pullup -
+// active-low, others - active-high), BUTTON_ACTIVE_LOW / BUTTON_ACTIVE_HIGH - the same for all buttons
+// (no pull mode compare in the poll path, pull mode only configures the pins)
+#define BUTTON_ACTIVE_BY_PULL_MODE 0
+#define BUTTON_ACTIVE_LOW 1
+#define BUTTON_ACTIVE_HIGH 2
+
+#ifndef BUTTON_CONTROL_ACTIVE_LEVEL
+    #define BUTTON_CONTROL_ACTIVE_LEVEL BUTTON_ACTIVE_BY_PULL_MODE
+#endif
+
+// Validation messages: 1 - button_initialization prints the wrong user data and asserts,
+// 0 - the checks and their strings are compiled out (status code APIs still check the data)
+#ifndef BUTTON_CONTROL_VALIDATION
+    #define BUTTON_CONTROL_VALIDATION 1
+#endif
+
+// Poll-path profiler: 1 - collect cycles per API and per section (sample / debounce / timers /
+// state machine / callbacks), 0 - profiler code is compiled out completely
+#ifndef BUTTON_CONTROL_PROFILER
+    #define BUTTON_CONTROL_PROFILER 0
+#endif
+
+// Contact health: 1 - every button sample updates the running contact statistics of the button (bounce
+// duration, rejected chatter, presses, hold durations), 0 - health code is compiled out completely
+// (default - off, the per-sample edge tracking is paid only by the builds that read the reports)
+#ifndef BUTTON_CONTROL_HEALTH
+    #define BUTTON_CONTROL_HEALTH 0
+#endif
+
+#define BUTTON_HEALTH_SETTLE_US 3000            // Level is settled after this time without edges (debounce time)
+
+#ifndef BUTTON_HEALTH_BOUNCE_LIMIT_US
+    #define BUTTON_HEALTH_BOUNCE_LIMIT_US 1000  // Recent bounce average for the degrading contact
+#endif
+
+#define BUTTON_HEALTH_HOLD_BUCKETS 8            // Hold durations histogram: < 128 ms, < 256 ms ... >= 8192 ms
+#define BUTTON_HEALTH_HOLD_BUCKET_MS 128        // Upper bound of the first bucket (bounds are doubled)
+
+// IRAM poll path: 1 - the sample / debounce / state machine / events path of the button APIs is placed
+// in IRAM (BUT_IRAM_ATTR), so the APIs keep working with the flash cache disabled (OTA / NVS / SPI flash
+// writes) and can be called from the IRAM-safe timer ISR. 0 - ordinary flash placement.
+// The whole path must be IRAM-resident too: the async_await lib (place it by the linker fragment of its
+// component: "[mapping:async_await] archive: libasync_await.a entries: * (noflash)"), the user callbacks /
+// event listeners / input sources (IRAM_ATTR) and the button ctxs (internal RAM, not PSRAM).
+#ifndef BUTTON_CONTROL_IRAM
+    #define BUTTON_CONTROL_IRAM 0
+#endif
+
+// Multiple press: 1 - multiple press APIs with their await and presses counter,
+// 0 - compiled out completely (no MULTIPRESS_AWAIT storage in the button ctx)
+#ifndef BUTTON_CONTROL_MULTIPRESS
+    #define BUTTON_CONTROL_MULTIPRESS 1
+#endif
+
+// Long-time press: 1 - long-time press APIs and the infinite press callback API with their await,
+// 0 - compiled out completely (no LONG_TIME_PRESS_AWAIT storage in the button ctx)
+#ifndef BUTTON_CONTROL_LONG_PRESS
+    #define BUTTON_CONTROL_LONG_PRESS 1
+#endif
+
+// Button events: 1 - the APIs report detected presses to the event listeners (event log, tasks and so on),
+// 0 - events code is compiled out completely
+#ifndef BUTTON_CONTROL_EVENTS
+    #define BUTTON_CONTROL_EVENTS 1
+#endif
+
+#ifndef BUTTON_EVENT_LISTENERS_MAX
+    #define BUTTON_EVENT_LISTENERS_MAX 4        // Maximum event listeners quantity
+#endif
+
+// Next wakeup: 1 - the awaits deadlines are tracked for the button_next_wakeup_us (tickless loops,
+// light sleep), 0 - deadlines tracking is compiled out completely
+#ifndef BUTTON_CONTROL_WAKEUP
+    #define BUTTON_CONTROL_WAKEUP 1
+#endif
+
+#define BUTTON_WAKEUP_ON_EDGE ((int64_t)-1)     // button_next_wakeup_us: all buttons idle, wake on the level edge only
+
+// Deep sleep retention: 1 - button state image for the RTC memory (button_state_save / resume),
+// 0 - compiled out completely
+#ifndef BUTTON_CONTROL_RETENTION
+    #define BUTTON_CONTROL_RETENTION 1
+#endif
+
+#ifndef BUTTON_STATE_IMAGE_MAX_BUTTONS
+    #define BUTTON_STATE_IMAGE_MAX_BUTTONS 16   // Buttons in one state image (4 bytes per button)
+#endif
+
+#define BUTTON_STATE_IMAGE_MAGIC 0x32535442     // "BTS2": detectors mask is stored as is (0 - no detectors)
+#define BUTTON_STATE_IMAGE_MAGIC_V1 0x31535442  // "BTS1": older images, detectors 0 - all
+
+// Flags publication: 1 - the flag APIs publish the flags into the atomic words of the publish banks
+// and the presses counters into the seqlock stats (lock-free reads from the other tasks / cores),
+// 0 - compiled out completely
+#ifndef BUTTON_CONTROL_PUBLISH
+    #define BUTTON_CONTROL_PUBLISH 1
+#endif
+
+#define BUTTON_PUBLISH_BANK_BUTTONS 8           // Buttons in one publish bank (4 flag bits per button in 32 bits)
+
+// Encoders: 1 - quadrature encoders are decoded from the same bank snapshot by the button_bank_sample,
+// 0 - compiled out completely
+#ifndef BUTTON_CONTROL_ENCODER
+    #define BUTTON_CONTROL_ENCODER 1
+#endif
+
+#ifndef BUTTON_ENCODERS_MAX
+    #define BUTTON_ENCODERS_MAX 4               // Maximum registered encoders quantity
+#endif
+
+// Simulated input: 1 - button levels may be taken from the user input source function instead of
+// the GPIO registers (for benchmarks and simulations), 0 - only the GPIO registers are read
+#ifndef BUTTON_CONTROL_SIM_INPUT
+    #define BUTTON_CONTROL_SIM_INPUT 0
+#endif
  
+#if BUTTON_CONTROL_PUBLISH
+    #ifdef __cplusplus
+        #include <atomic>                       // For the publish banks (same layout as the C11 atomics)
+        typedef std::atomic<uint_least32_t> button_atomic_u32;
+    #else
+        #include <stdatomic.h>                  // For the publish banks
+        typedef atomic_uint_least32_t button_atomic_u32;
+    #endif
+#endif
+
+#if BUTTON_CONTROL_IRAM
+    #include "esp_attr.h"                       // For IRAM_ATTR / DRAM_ATTR
+    #define BUT_IRAM_ATTR IRAM_ATTR             // Poll path code
+    #define BUT_DRAM_ATTR DRAM_ATTR             // Data of the poll path (internal RAM, constants are not in the flash rodata)
+#else
+    #define BUT_IRAM_ATTR
+    #define BUT_DRAM_ATTR
+#endif
+
 // =========================================================================================== DEFINES
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
 // =========================================================================================== EXT CONST
 
 
@@ -65,12 +393,193 @@ typedef enum {
 
 } button_type;
 
+
+// Button detectors (bits of the button detectors mask): the APIs of the disabled detectors return at once
+typedef enum {
+
+    BUTTON_DETECT_ONETIME = 1 << 0,     // *_control_by_but_onetime_press
+    BUTTON_DETECT_MULTIPLE = 1 << 1,    // *_control_by_but_multiple_press
+    BUTTON_DETECT_LONGTIME = 1 << 2,    // *_control_by_but_longtime_press
+    BUTTON_DETECT_INFINITE = 1 << 3,    // *_control_by_but_infinite_press
+
+    BUTTON_DETECT_ALL = 0x0F
+
+} button_detector;
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Button event types
+typedef enum {
+
+    BUTTON_EVENT_ONETIME_PRESS,         // Short press is detected (on release)
+    BUTTON_EVENT_MULTIPLE_PRESS,        // Multiple press is detected (count - presses quantity)
+    BUTTON_EVENT_LONG_PRESS,            // Long-time press is detected (still held)
+    BUTTON_EVENT_INFINITE_PRESS_START,  // Infinite press started
+    BUTTON_EVENT_INFINITE_PRESS_END,    // Infinite press ended (on release)
+    BUTTON_EVENT_CONTACT_DEGRADING,     // Recent bounce average passed BUTTON_HEALTH_BOUNCE_LIMIT_US (BUTTON_CONTROL_HEALTH)
+
+    BUTTON_EVENT_QUANTITY
+
+} button_event_type;
+
+#endif // BUTTON_CONTROL_EVENTS
+
+
+#if BUTTON_CONTROL_PUBLISH
+
+// Published flags of one button (bit = publish_index * BUTTON_PUBLISH_FLAGS_QUANTITY + flag)
+typedef enum {
+
+    BUTTON_PUBLISH_ONETIME,             // flag_control_by_but_onetime_press flag
+    BUTTON_PUBLISH_MULTIPLE,            // flag_control_by_but_multiple_press flag (the last switched one)
+    BUTTON_PUBLISH_LONGTIME,            // flag_control_by_but_longtime_press flag
+    BUTTON_PUBLISH_INFINITE,            // flag_control_by_but_infinite_press flag
+
+    BUTTON_PUBLISH_FLAGS_QUANTITY
+
+} button_publish_flag;
+
+#endif // BUTTON_CONTROL_PUBLISH
+
+
+#if BUTTON_CONTROL_PROFILER
+
+// Profiled APIs (one counters row per API)
+typedef enum {
+
+    BUT_PROF_API_FLAG_ONETIME,          // flag_control_by_but_onetime_press
+    BUT_PROF_API_FLAG_MULTIPLE,         // flag_control_by_but_multiple_press
+    BUT_PROF_API_FLAG_LONGTIME,         // flag_control_by_but_longtime_press
+    BUT_PROF_API_FLAG_INFINITE,         // flag_control_by_but_infinite_press
+
+    BUT_PROF_API_CALLBACK_ONETIME,      // callback_control_by_but_onetime_press
+    BUT_PROF_API_CALLBACK_MULTIPLE,     // callback_control_by_but_multiple_press
+    BUT_PROF_API_CALLBACK_LONGTIME,     // callback_control_by_but_longtime_press
+    BUT_PROF_API_CALLBACK_INFINITE,     // callback_control_by_but_infinite_press
+
+    BUT_PROF_API_QUANTITY
+
+} button_profiler_api;
+
+// Profiled sections of one API call (one counter per section)
+typedef enum {
+
+    BUT_PROF_SECTION_SAMPLE,            // GPIO read
+    BUT_PROF_SECTION_DEBOUNCE,          // Debounce await
+    BUT_PROF_SECTION_TIMERS,            // Multipress / long-time press awaits
+    BUT_PROF_SECTION_STATE_MACHINE,     // Everything else inside the call (total minus other sections)
+    BUT_PROF_SECTION_CALLBACK,          // User callbacks performance
+    BUT_PROF_SECTION_TOTAL,             // Whole API call
+
+    BUT_PROF_SECTION_QUANTITY
+
+} button_profiler_section;
+
+#endif // BUTTON_CONTROL_PROFILER
+
 // =========================================================================================== EXT ENUMS
 
 
 
 // =========================================================================================== EXT STRUCTS
 
+// Input bank snapshot structure (raw levels of all GPIOs for one tick)
+typedef struct
+{
+    uint32_t in;                                    // GPIO 0..31 levels
+    uint32_t in1;                                   // GPIO 32..63 levels
+
+} button_bank_snapshot;
+
+
+#if BUTTON_CONTROL_PROFILER
+
+// Profiler counter structure (cycles by the CPU cycle counter)
+typedef struct
+{
+    uint32_t calls;                                 // Measured calls quantity
+    uint64_t total_cycles;                          // Sum of the measured cycles (for the average)
+    uint32_t min_cycles;                            // Fastest measured call
+    uint32_t max_cycles;                            // Slowest measured call
+
+} button_profiler_counter;
+
+#endif // BUTTON_CONTROL_PROFILER
+
+
+#if BUTTON_CONTROL_HEALTH
+
+// Contact health statistics of one button (running values, O(1) memory)
+typedef struct
+{
+    uint32_t presses;                               // Settled presses (since the initialization / health reset)
+    uint32_t transitions;                           // Settled level changes (press + release)
+    uint32_t bounces;                               // Transitions with more than one edge
+    uint32_t chatter_rejected;                      // Pulses shorter than the settle time (level came back)
+
+    uint64_t bounce_total_us;                       // Sum of the bounce durations (mean = total / transitions)
+    uint32_t bounce_max_us;                         // Longest bounce
+    uint32_t bounce_recent_us;                      // Recent bounce average (exponential, 1/8 weight of the new one)
+
+    uint32_t hold_histogram[BUTTON_HEALTH_HOLD_BUCKETS];    // Settled holds per duration bucket
+
+    bool degrading;                                 // Recent bounce average is above BUTTON_HEALTH_BOUNCE_LIMIT_US
+
+} button_health_stats;
+
+// Contact health tracking of the button ctx
+typedef struct
+{
+    button_health_stats stats;
+
+    int64_t edge_first_us;                          // First edge of the unsettled level
+    int64_t edge_last_us;                           // Last edge of the unsettled level
+    int64_t press_us;                               // Settled press start (for the hold duration)
+
+    uint8_t edges;                                  // Edges since the settled level (0 - level is settled)
+    bool level;                                     // Last sampled level
+    bool settled_level;                             // Last settled level
+
+} button_health;
+
+// Contact health report of one button (button_health_snapshot)
+typedef struct
+{
+    gpio_num_t PIN;                                 // Button pin
+    uint32_t bounce_mean_us;                        // Mean bounce duration of all transitions
+
+    button_health_stats stats;
+
+} button_health_report;
+
+#endif // BUTTON_CONTROL_HEALTH
+
+
+#if BUTTON_CONTROL_PUBLISH
+
+// Published counters of the bank (read by the button_publish_stats_read)
+typedef struct
+{
+    uint32_t flag_changes[BUTTON_PUBLISH_BANK_BUTTONS];     // Published flag switches per button
+    uint8_t presses_counter[BUTTON_PUBLISH_BANK_BUTTONS];   // Multipress counters per button
+    int64_t last_change_us;                                 // Time of the last change (button_time_us)
+
+} button_publish_stats;
+
+// Publish bank structure (one writer - the task with the button APIs, any readers)
+typedef struct
+{
+    button_atomic_u32 flags;                        // Flag bits of all bank buttons
+    button_atomic_u32 sequence;                     // Stats seqlock sequence (odd - the write is in progress)
+
+    button_publish_stats stats;                     // Stats, written under the seqlock
+
+} button_publish_bank;
+
+#endif // BUTTON_CONTROL_PUBLISH
+
+
 // Button structure
 typedef struct
 {
@@ -78,6 +587,7 @@ typedef struct
     gpio_pull_mode_t pull_mode;                     // Control type (pullup / pulldown)
 
     button_type type;                               // Button type
+    uint8_t detectors;                              // Enabled detectors (button_detector bits)
 
     bool but_pressed;                               // Flag for button press state control
     bool but_long_pressed;                          // Flag for button press state control
@@ -88,26 +598,163 @@ typedef struct
 
     bool long_time_await_end;
 
+#if BUTTON_CONTROL_MULTIPRESS
     unsigned int presses_counter;                   // Variable for presses quantity control
     uint8_t max_presses_quantity;                   // Variable for reset logic
+#endif
 
+#if BUTTON_CONTROL_CALLBACKS
     void (*onetime_press_callback)(void);           // Callback function for onetime press
 
+#if BUTTON_CONTROL_MULTIPRESS
     void (*multiple_press_callback)(void);          // Callback function for multiple press
+#endif
 
+#if BUTTON_CONTROL_LONG_PRESS
     void (*long_time_press_callback)(void);         // Callback function for long_time press
     bool long_time_press_permission;                // Flag for the callback use
 
     void (*infinite_press_callback)(void);          // Callback function for infinite press
     bool infinite_press_permission;                 // Flag for the callback use
+#endif
+#endif // BUTTON_CONTROL_CALLBACKS
 
     async_await_ctx DEBOUNCE_AWAIT;                 // Async await context for debounce await
+
+#if BUTTON_CONTROL_MULTIPRESS
     async_await_ctx MULTIPRESS_AWAIT;               // Async await context for multipress await reset
+#endif
+
+#if BUTTON_CONTROL_LONG_PRESS
     async_await_ctx LONG_TIME_PRESS_AWAIT;          // Async await context for multipress await reset
+#endif
+
+#if BUTTON_CONTROL_WAKEUP
+    int64_t timer_deadline_us[3];                   // DEBOUNCE / MULTIPRESS / LONG_TIME_PRESS awaits deadlines (0 - not armed)
+#endif
+
+#if BUTTON_CONTROL_EVENTS
+    int64_t press_start_us;                         // Debounced press time for the hold duration of the events
+#endif
+
+#if BUTTON_CONTROL_PROFILER
+    button_profiler_counter profiler;               // Total cycles of all API calls for this button
+#endif
+
+#if BUTTON_CONTROL_HEALTH
+    button_health health;                           // Contact health statistics (button_health_snapshot)
+#endif
+
+#if BUTTON_CONTROL_PUBLISH
+    button_publish_bank *publish_bank;              // Bank for the flags publication (NULL - not published)
+    uint8_t publish_index;                          // Button place in the bank
+#endif
+
+#if BUTTON_CONTROL_SIM_INPUT
+    int64_t sim_timer_start_us[3];                  // DEBOUNCE / MULTIPRESS / LONG_TIME_PRESS starts on the time source clock
+    uint8_t sim_timers_running;                     // Running timers bits (time source awaits)
+#endif
 
 } button_ctx;
 
 
+#if BUTTON_CONTROL_RETENTION
+
+// Button record of the state image
+typedef struct
+{
+    uint8_t PIN;                                    // Button pin
+    uint8_t config;                                 // Pull mode (bits 0..1), type (bit 2)
+    uint8_t max_presses_quantity;                   // Multipress reset logic value
+    uint8_t detectors;                              // Enabled detectors (button_detector bits)
+
+} button_state_record;
+
+// Button state image structure (keep it in RTC_DATA_ATTR memory)
+typedef struct
+{
+    uint32_t magic;                                 // BUTTON_STATE_IMAGE_MAGIC (BUTTON_STATE_IMAGE_MAGIC_V1 is restored too)
+    uint8_t quantity;                               // Saved buttons quantity
+    uint8_t reserved[3];
+
+    button_state_record buttons[BUTTON_STATE_IMAGE_MAX_BUTTONS];
+
+    uint32_t checksum;                              // Checksum of all the previous bytes
+
+} button_state_image;
+
+#endif // BUTTON_CONTROL_RETENTION
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Button event structure
+typedef struct
+{
+    const button_ctx *button;                       // Source button
+    gpio_num_t PIN;                                 // Source button pin
+    button_event_type type;                         // Event type
+
+    uint8_t count;                                  // Presses quantity (1 for the single press events)
+    uint32_t hold_ms;                               // Time from the debounced press to the event
+    int64_t time_us;                                // Event time (button_time_us)
+
+} button_event;
+
+// Event listener type: called from the button API, that detected the event (keep it short)
+typedef void (*button_event_listener)(const button_event *event, void *user);
+
+#endif // BUTTON_CONTROL_EVENTS
+
+
+// Button user data structure (for the bulk initialization)
+typedef struct
+{
+    gpio_num_t PIN;                                 // Pin for button control
+    gpio_pull_mode_t pull_mode;                     // Control type (pullup / pulldown)
+    button_type type;                               // Button type
+    uint8_t detectors;                              // Enabled detectors (button_detector bits, 0 - all)
+
+} button_config;
+
+
+#if BUTTON_CONTROL_ENCODER
+
+// Quadrature encoder structure (decoded by the button_bank_sample, push-button is an ordinary button ctx)
+typedef struct
+{
+    gpio_num_t PIN_A;                               // Channel A pin
+    gpio_num_t PIN_B;                               // Channel B pin
+
+    uint8_t steps_per_detent;                       // Quadrature steps of one detent (4 - full cycle, 2, 1)
+    uint8_t state;                                  // Last AB levels (A - bit 1, B - bit 0)
+    int8_t sub_steps;                               // Steps inside the current detent
+
+    int32_t position;                               // Detents from the initialization (CW - positive)
+    int32_t delta;                                  // Detents since the last button_encoder_delta_take
+
+    uint32_t steps;                                 // Valid quadrature steps
+    uint32_t errors;                                // Skipped states (both channels changed in one tick - too fast)
+
+} button_encoder;
+
+#endif // BUTTON_CONTROL_ENCODER
+
+
+#if BUTTON_CONTROL_SIM_INPUT
+
+// Simulated input source type: returns the raw pin level (0 / 1, before the pull mode logic) for the button
+typedef int (*button_input_source)(const button_ctx *button);
+
+// Simulated bank source type: fills the raw levels of all GPIOs for the button_bank_sample call
+typedef void (*button_bank_source)(button_bank_snapshot *snapshot);
+
+// Simulated time source type: returns the current time of the button engine in us
+typedef int64_t (*button_time_source)(void);
+
+#endif // BUTTON_CONTROL_SIM_INPUT
+
+
 // =========================================================================================== EXT STRUCTS
 
 
@@ -121,6 +768,27 @@ typedef struct
 button_ctx button_initialization(gpio_num_t PIN, gpio_pull_mode_t pull_mode, button_type type);
 
 
+// Function: button_initialization_in_place
+// Button ctx constructor without the ctx copy and asserts.
+// Fills the caller ctx and configures the pin by one gpio_config call.
+// Returns ESP_ERR_INVALID_ARG for the wrong data (ctx is untouched then) or the gpio_config error.
+// Call as: esp_err_t error = button_initialization_in_place(&button_1, BUT_PIN, GPIO_PULLUP_ONLY, NO_FIX);
+esp_err_t button_initialization_in_place(button_ctx *button, gpio_num_t PIN, gpio_pull_mode_t pull_mode, button_type type);
+
+
+// Function: button_initialization_bulk
+// Buttons ctx constructor for the whole array of buttons (fast startup for the big keyboards).
+// Checks all the configs first, fills the caller ctxs in place and configures all the pins with
+// one gpio_config call per used pull mode (pin masks).
+// Returns ESP_ERR_INVALID_ARG for any wrong config (ctxs are untouched then) or the gpio_config error.
+// Call as:
+// static const button_config configs[] = { { GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX, BUTTON_DETECT_ONETIME },
+//                                          { GPIO_NUM_5, GPIO_PULLUP_ONLY, FIX } };     // 0 detectors - all
+// static button_ctx buttons[2];
+// esp_err_t error = button_initialization_bulk(buttons, configs, 2);
+esp_err_t button_initialization_bulk(button_ctx buttons[], const button_config configs[], size_t quantity);
+
+
 // Function: flag_control_by_but_onetime_press
 // Purpose: Reverse the flag parameter bool value by the short button press and save this flag state
 // by the selected button and flag with debounce async await. 
@@ -137,6 +805,8 @@ button_ctx button_initialization(gpio_num_t PIN, gpio_pull_mode_t pull_mode, but
 void flag_control_by_but_onetime_press(button_ctx *button, bool* flag);
 
 
+#if BUTTON_CONTROL_MULTIPRESS
+
 // Function: flag_control_by_but_onetime_press
 // Purpose: Reverse the flag parameter bool value by the short button press and save this flag state
 // by the selected button and flag with debounce async await. 
@@ -147,6 +817,11 @@ void flag_control_by_but_multiple_press(button_ctx *button, bool* flag, uint8_t
 
 void multitime_press_counter_control(button_ctx *button);
 
+#endif // BUTTON_CONTROL_MULTIPRESS
+
+
+#if BUTTON_CONTROL_LONG_PRESS
+
 // Function: flag_control_by_but_onetime_press
 // Purpose: Reverse the flag parameter bool value by the longtime button press (3 seconds) and save this flag state
 // by the selected button and flag with debounce and press timer async await.
@@ -161,6 +836,8 @@ void multitime_press_counter_control(button_ctx *button);
 // Than check the flag in if-else, like: if (my flag) { ... }
 void flag_control_by_but_longtime_press(button_ctx *button, bool* flag);
 
+#endif // BUTTON_CONTROL_LONG_PRESS
+
 
 // Function: flag_control_by_but_infinite_press
 // Purpose: Reverse the flag parameter bool value by the endless button press and return the
@@ -178,6 +855,8 @@ void flag_control_by_but_infinite_press(button_ctx *button, bool* flag);
 
 
 
+#if BUTTON_CONTROL_CALLBACKS
+
 // Function: callback_control_by_but_onetime_press
 // Purpose:  loop / multiple perform the void function by the short button press.
 // Works by the selected button and repeats value with debounce async await. 
@@ -186,6 +865,8 @@ void flag_control_by_but_infinite_press(button_ctx *button, bool* flag);
 void callback_control_by_but_onetime_press(button_ctx *button, unsigned int repeats);
 
 
+#if BUTTON_CONTROL_MULTIPRESS
+
 // Function: callback_control_by_but_multiple_press
 // Purpose: loop / multiple perform the void function by the multiple button press.
 // Works by the selected button, repeats value and presses quantity with debounce async await. 
@@ -193,6 +874,11 @@ void callback_control_by_but_onetime_press(button_ctx *button, unsigned int repe
 // Call as: callback_control_by_but_multiple_press(&button_1, 5, LOOP_PERFORMANCE);
 void callback_control_by_but_multiple_press(button_ctx *button, uint8_t presses_quantity, unsigned int repeats);
 
+#endif // BUTTON_CONTROL_MULTIPRESS
+
+
+#if BUTTON_CONTROL_LONG_PRESS
+
 
 // Function: callback_control_by_but_longtime_press
 // Purpose: loop / multiple perform the void function by the long button press.
@@ -210,10 +896,262 @@ void callback_control_by_but_longtime_press(button_ctx *button, unsigned int rep
 // Call as: callback_control_by_but_longtime_press(&button_1, 2);
 void callback_control_by_but_infinite_press(button_ctx *button, unsigned int repeats);
 
+#endif // BUTTON_CONTROL_LONG_PRESS
+
+#endif // BUTTON_CONTROL_CALLBACKS
+
+
+// Function: button_detectors_set
+// Purpose: Set the enabled detectors of the button (button_detector bits). The APIs of the disabled
+// detectors return at once, so the simple keys don't pay for the unused logic.
+// button_initialization enables all detectors, button_initialization_bulk takes them from the config.
+// Call as: button_detectors_set(&button_1, BUTTON_DETECT_ONETIME);
+void button_detectors_set(button_ctx *button, uint8_t detectors);
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Function: button_event_listener_add
+// Purpose: Add the event listener for all buttons (up to BUTTON_EVENT_LISTENERS_MAX).
+// user pointer is passed back to the listener. Returns false if there is no free listener slot.
+// Call as: button_event_listener_add(my_listener, &my_data);
+bool button_event_listener_add(button_event_listener listener, void *user);
+
+
+// Function: button_event_listener_remove
+// Purpose: Remove the event listener added with the same user pointer.
+// Call as: button_event_listener_remove(my_listener, &my_data);
+void button_event_listener_remove(button_event_listener listener, void *user);
+
+#endif // BUTTON_CONTROL_EVENTS
+
+
+#if BUTTON_CONTROL_WAKEUP
+
+// Function: button_next_wakeup_us
+// Purpose: Return the time in us until the next moment, when the button APIs have something to do
+// (debounce / long-time press / multipress series end), 0 if the APIs must be called right now, or
+// BUTTON_WAKEUP_ON_EDGE if all buttons are idle and only a level edge on their pins can change it.
+// Call after the button APIs of the loop pass. Then sleep / block until the returned time or the edge
+// of any button pin (gpio_wakeup_enable / GPIO interrupt).
+// Every button must be served by at least one API, or it looks like a press under debounce.
+// Call as: int64_t next_us = button_next_wakeup_us(buttons, 3);  // button_ctx *buttons[] = { &button_1, ... };
+int64_t button_next_wakeup_us(button_ctx *const buttons[], size_t quantity);
+
+#endif // BUTTON_CONTROL_WAKEUP
+
+
+#if BUTTON_CONTROL_RETENTION
+
+// Function: button_state_save
+// Purpose: Save the buttons into the compact state image (call right before esp_deep_sleep_start).
+// Returns false if there are more buttons than BUTTON_STATE_IMAGE_MAX_BUTTONS.
+// Call as: button_state_save(&rtc_button_image, buttons, 3);   // RTC_DATA_ATTR button_state_image rtc_button_image;
+bool button_state_save(button_state_image *image, button_ctx *const buttons[], size_t quantity);
+
+
+// Function: button_state_restore
+// Purpose: Fill the button ctxs from the image without any hardware access (callbacks and the
+// button_publish_attach links are set by the user again, as after the button_initialization).
+// Returns false if the image is empty / broken or the quantity differs.
+// Call as: button_state_restore(&rtc_button_image, buttons, 3);
+bool button_state_restore(const button_state_image *image, button_ctx *const buttons[], size_t quantity);
+
+
+// Function: button_state_resume
+// Purpose: Instead of the button_initialization after the deep sleep wakeup: restore the buttons, configure
+// their pins and take the wakeup press at once. Buttons from the wake_pins mask (bit per GPIO, for example
+// esp_sleep_get_ext1_wakeup_status()) skip the debounce: a held button continues as a debounced press
+// (long-time press await starts on the first poll), a released one is reported as a short press by the
+// first poll. Returns false if the image is empty / broken - use button_initialization then.
+// Callbacks and the button_publish_attach links are set again after it (see button_state_restore).
+// Call as: if (!button_state_resume(&rtc_button_image, buttons, 3, esp_sleep_get_ext1_wakeup_status())) { ... }
+bool button_state_resume(const button_state_image *image, button_ctx *const buttons[], size_t quantity,
+                         uint64_t wake_pins);
+
+#endif // BUTTON_CONTROL_RETENTION
+
+
+#if BUTTON_CONTROL_PUBLISH
+
+// Function: button_publish_bank_init
+// Purpose: Reset the publish bank (all flags false, zero stats).
+// Call as: button_publish_bank_init(&panel_bank);
+void button_publish_bank_init(button_publish_bank *bank);
+
+
+// Function: button_publish_attach
+// Purpose: Publish the flags and the presses counter of the button into the bank at the index place
+// (0 .. BUTTON_PUBLISH_BANK_BUTTONS - 1). Call after the button initialization and after the
+// button_state_restore / button_state_resume (NULL bank - stop the publication). All bank buttons must be served by the APIs of one task. Returns false for the wrong index.
+// Call as: button_publish_attach(&button_1, &panel_bank, 0);
+bool button_publish_attach(button_ctx *button, button_publish_bank *bank, uint8_t index);
+
+
+// Function: button_publish_flags_read
+// Purpose: Return all flag bits of the bank by one atomic load (any task / core, no locks).
+// Call as: uint32_t flags = button_publish_flags_read(&panel_bank);
+uint32_t button_publish_flags_read(const button_publish_bank *bank);
+
+
+// Function: button_publish_flag_get
+// Purpose: Return the published flag of the button at the index place of the bank.
+// Call as: if (button_publish_flag_get(&panel_bank, 0, BUTTON_PUBLISH_LONGTIME)) { ... }
+bool button_publish_flag_get(const button_publish_bank *bank, uint8_t index, button_publish_flag flag);
+
+
+// Function: button_publish_stats_read
+// Purpose: Copy the consistent stats snapshot of the bank (seqlock: the copy is retried while the
+// writer is inside). Never blocks the writer.
+// Call as: button_publish_stats stats; button_publish_stats_read(&panel_bank, &stats);
+void button_publish_stats_read(const button_publish_bank *bank, button_publish_stats *stats);
+
+#endif // BUTTON_CONTROL_PUBLISH
+
+
+// Function: button_bank_sample
+// Purpose: Read all the GPIO input registers once and latch them for the current tick.
+// After the first call all the button APIs read their levels from the latched snapshot instead of the
+// registers, so call it once at the start of every loop pass (before the button APIs).
+// Returns the latched snapshot (for the trace recorder, logging and so on).
+// Call as: const button_bank_snapshot *bank = button_bank_sample();
+const button_bank_snapshot *button_bank_sample(void);
+
+
+// Function: button_time_us
+// Purpose: Return the current time of the button engine in us: esp_timer_get_time() or the simulated
+// time source (button_time_source_set). Awaits, events, publish and health times are counted by it.
+// Call as: int64_t now_us = button_time_us();
+int64_t button_time_us(void);
+
+
+// Function: button_is_held
+// Purpose: Return the current pressed level of the button, read the same way as the button APIs do:
+// latched bank / register / simulated source, active level by BUTTON_CONTROL_ACTIVE_LEVEL or the pull mode.
+// Raw level (no debounce).
+// Call as: if (button_is_held(&but_ok)) ...
+bool button_is_held(const button_ctx *button);
+
+
+#if BUTTON_CONTROL_ENCODER
+
+// Function: button_encoder_initialization
+// Purpose: Configure the encoder pins and register the encoder in the bank (up to BUTTON_ENCODERS_MAX).
+// Every button_bank_sample decodes the registered encoders from the edges of the latched snapshot,
+// so one sample pass serves the buttons and the encoders. Encoder must stay alive while registered.
+// The encoder push-button is initialized as an ordinary button (all its press APIs work).
+// Returns ESP_ERR_INVALID_ARG for the wrong pins / steps, ESP_ERR_NO_MEM if there is no free encoder slot.
+// Call as: button_encoder_initialization(&volume, GPIO_NUM_18, GPIO_NUM_19, GPIO_PULLUP_ONLY, 4);
+esp_err_t button_encoder_initialization(button_encoder *encoder, gpio_num_t PIN_A, gpio_num_t PIN_B,
+                                        gpio_pull_mode_t pull_mode, uint8_t steps_per_detent);
+
+
+// Function: button_encoder_remove
+// Purpose: Unregister the encoder from the bank decoding.
+// Call as: button_encoder_remove(&volume);
+void button_encoder_remove(button_encoder *encoder);
+
+
+// Function: button_encoder_delta_take
+// Purpose: Return the detents since the previous call (CW - positive) and reset them.
+// Call from the task of the button_bank_sample.
+// Call as: volume_level += button_encoder_delta_take(&volume);
+int32_t button_encoder_delta_take(button_encoder *encoder);
+
+#endif // BUTTON_CONTROL_ENCODER
+
+
+#if BUTTON_CONTROL_PROFILER
+
+// Function: button_profiler_get
+// Purpose: Return the counter copy of the selected API and section.
+// Per-button totals are available directly as button_1.profiler.
+// Call as: button_profiler_counter c = button_profiler_get(BUT_PROF_API_FLAG_ONETIME, BUT_PROF_SECTION_TOTAL);
+button_profiler_counter button_profiler_get(button_profiler_api api, button_profiler_section section);
+
+
+// Function: button_profiler_average
+// Purpose: Return the average cycles of the counter (0 if there were no calls).
+// Call as: uint32_t avg = button_profiler_average(&c);
+uint32_t button_profiler_average(const button_profiler_counter *counter);
+
+
+// Function: button_profiler_reset
+// Purpose: Reset all the API / section counters (per-button counters are reset by the button_profiler_reset_button).
+// Call as: button_profiler_reset();
+void button_profiler_reset(void);
+
+
+// Function: button_profiler_reset_button
+// Purpose: Reset the per-button total counter.
+// Call as: button_profiler_reset_button(&button_1);
+void button_profiler_reset_button(button_ctx *button);
+
+
+// Function: button_profiler_print
+// Purpose: Print the min / avg / max cycles table for all APIs with calls by printf.
+// Call as: button_profiler_print();
+void button_profiler_print(void);
+
+#endif // BUTTON_CONTROL_PROFILER
+
+
+#if BUTTON_CONTROL_HEALTH
+
+// Function: button_health_snapshot
+// Purpose: Copy the contact health statistics of the buttons into the reports (one report per button,
+// with the mean bounce duration). Call from the task of the button APIs, then send / store the reports.
+// Statistics are updated by every API call of the button: edges that settle within BUTTON_HEALTH_SETTLE_US
+// are one bounce, a pulse that returns to the settled level is the rejected chatter.
+// BUTTON_EVENT_CONTACT_DEGRADING is reported once, when the recent bounce average passes
+// BUTTON_HEALTH_BOUNCE_LIMIT_US (again after it falls below 3/4 of the limit).
+// Call as: button_health_snapshot(buttons, 3, reports);   // button_health_report reports[3];
+void button_health_snapshot(button_ctx *const buttons[], size_t quantity, button_health_report reports[]);
+
+
+// Function: button_health_reset
+// Purpose: Reset the contact health statistics of the button (after the switch replacement).
+// Call as: button_health_reset(&button_1);
+void button_health_reset(button_ctx *button);
+
+#endif // BUTTON_CONTROL_HEALTH
+
+
+#if BUTTON_CONTROL_SIM_INPUT
+
+// Function: button_input_source_set
+// Purpose: Replace the GPIO registers read of all buttons by the simulated input source.
+// Pass NULL to return to the GPIO registers.
+// Call as: button_input_source_set(my_simulated_levels);
+void button_input_source_set(button_input_source source);
+
+
+// Function: button_bank_source_set
+// Purpose: Replace the GPIO registers read of the button_bank_sample by the simulated bank source
+// (trace replay and so on). Pass NULL to return to the GPIO registers.
+// Call as: button_bank_source_set(my_simulated_bank);
+void button_bank_source_set(button_bank_source source);
+
+
+// Function: button_time_source_set
+// Purpose: Replace the esp_timer clock of the button engine by the simulated time source: the awaits of
+// all buttons (debounce / multipress / long-time press), the events, publish and health times follow it,
+// so the simulations / trace replays run faster than the real time and repeat the same results.
+// Set it before the first API calls of the buttons (running awaits are not moved between the clocks).
+// Pass NULL to return to esp_timer_get_time().
+// Call as: button_time_source_set(my_virtual_clock);
+void button_time_source_set(button_time_source source);
+
+#endif // BUTTON_CONTROL_SIM_INPUT
+
 
 // =========================================================================================== API
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // BUTTON_CONTROL_H
 
 // =========================================================================================== INSTRUCTION
@@ -0,0 +1,369 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control (Header File, C++ version)
+
+// Author: dimakomplekt
+
+// Description: Header-only compile-time buttons for the C++ firmware. Pin, pull mode, type and timings
+// are template parameters, so the input register, the bit mask and the polarity are constexpr:
+// the button read is one register load, one xor and one mask, without the runtime pin indexing and
+// the pull mode switch of the C version. ButtonBank reads every used input register once per poll
+// and serves all its buttons from that snapshot.
+
+// Gestures are the same, as in the C version: onetime press (on release), multiple press (after the
+// multipress pause), long-time press (while held), infinite press start / end (FIX buttons).
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_HPP
+#define BUTTON_CONTROL_HPP
+
+// =========================================================================================== IMPORT
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#include "button_control.h"                     // For button_type, button_bank_snapshot and the C APIs
+
+#include "esp_timer.h"                          // For esp_timer_get_time()
+
+// =========================================================================================== IMPORT
+
+
+namespace button_control {
+
+// =========================================================================================== TIMINGS
+
+// Button timings (defaults - the C version timings)
+template <uint32_t DebounceMs = 3, uint32_t MultipressMs = 1000, uint32_t LongPressMs = BUTTON_LONG_PRESS_S * 1000>
+struct Timing
+{
+    static constexpr int64_t debounce_us = DebounceMs * 1000LL;        // Press confirmation
+    static constexpr int64_t multipress_us = MultipressMs * 1000LL;    // Pause, that ends the presses series
+    static constexpr int64_t long_press_us = LongPressMs * 1000LL;     // Hold for the long-time press
+
+    static_assert(DebounceMs < LongPressMs, "Debounce must be shorter than the long-time press");
+};
+
+// =========================================================================================== TIMINGS
+
+
+// =========================================================================================== GESTURES
+
+// Detected gesture
+enum class Gesture : uint8_t {
+
+    None,
+    Onetime,            // Short press is released (count - presses in the current series)
+    Multiple,           // Presses series is ended by the multipress pause (count - presses quantity)
+    LongPress,          // Long-time press (still held)
+    InfiniteStart,      // FIX button is switched on
+    InfiniteEnd,        // FIX button is switched off
+
+};
+
+// Gesture with its presses quantity
+struct GestureEvent
+{
+    Gesture gesture;
+    uint8_t count;
+
+    constexpr explicit operator bool() const { return gesture != Gesture::None; }
+};
+
+// =========================================================================================== GESTURES
+
+
+// =========================================================================================== BUTTON
+
+template <gpio_num_t Pin, gpio_pull_mode_t Pull = GPIO_PULLUP_ONLY, button_type Type = NO_FIX,
+          typename Timings = Timing<>>
+class Button
+{
+public:
+
+    // Compile-time layout
+    static_assert(Pin >= 0 && Pin < TOTAL_PINS && GPIO_IS_VALID_GPIO(Pin), "Wrong button pin for the target chip");
+
+    static constexpr gpio_num_t pin = Pin;
+    static constexpr gpio_pull_mode_t pull_mode = Pull;
+    static constexpr button_type type = Type;
+
+    static constexpr bool high_bank = (Pin >= BUTTON_GPIO_LOW_BANK_PINS);    // GPIO_IN1_REG pin
+    static constexpr uint32_t mask = 1u << (Pin & 31);                      // Bit in the input word
+    static constexpr uint32_t invert = (Pull == GPIO_PULLUP_ONLY) ? mask : 0u;  // Active-low polarity
+    static constexpr uint64_t pin_mask = 1ULL << Pin;                       // Bit for the gpio_config
+
+    // Pin configuration (single button; ButtonBank configures all its pins by masks)
+    static esp_err_t configure()
+    {
+        gpio_config_t config = {};
+
+        config.pin_bit_mask = pin_mask;
+        config.mode = GPIO_MODE_INPUT;
+        config.pull_up_en = (Pull == GPIO_PULLUP_ONLY || Pull == GPIO_PULLUP_PULLDOWN) ? GPIO_PULLUP_ENABLE
+                                                                                       : GPIO_PULLUP_DISABLE;
+        config.pull_down_en = (Pull == GPIO_PULLDOWN_ONLY || Pull == GPIO_PULLUP_PULLDOWN) ? GPIO_PULLDOWN_ENABLE
+                                                                                           : GPIO_PULLDOWN_DISABLE;
+        config.intr_type = GPIO_INTR_DISABLE;
+
+        return gpio_config(&config);
+    }
+
+    // Pressed level from the input word of the pin bank: xor + mask, no branches
+    static constexpr bool level(uint32_t input_word)
+    {
+        return ((input_word ^ invert) & mask) != 0;
+    }
+
+    // Pressed level from the bank snapshot
+    static constexpr bool level(const button_bank_snapshot &bank)
+    {
+        return level(high_bank ? bank.in1 : bank.in);
+    }
+
+    // Pressed level by the direct register read: load + xor + mask
+    static bool read()
+    {
+#if BUTTON_GPIO_HIGH_BANK
+        if constexpr (high_bank) return level(REG_READ(GPIO_IN1_REG));
+#endif
+        return level(REG_READ(GPIO_IN_REG));
+    }
+
+    // Gesture detection by the pressed level at the time
+    GestureEvent update(bool pressed, int64_t now_us)
+    {
+        switch (state)
+        {
+            case State::Released:
+
+                if (pressed)
+                {
+                    state = State::Debounce;
+                    since_us = now_us;
+                }
+                else if (presses > 0 && now_us >= series_end_us)
+                {
+                    // Presses series end
+                    uint8_t count = presses;
+                    presses = 0;
+
+                    if (Type == NO_FIX && count > 1) return { Gesture::Multiple, count };
+                }
+                break;
+
+            case State::Debounce:
+
+                if (!pressed) state = State::Released;      // Bounce
+                else if (now_us - since_us >= Timings::debounce_us)
+                {
+                    state = State::Pressed;
+                    since_us = now_us;
+
+                    if (Type == FIX) return { Gesture::InfiniteStart, 1 };
+                }
+                break;
+
+            case State::Pressed:
+
+                if (!pressed)
+                {
+                    state = State::Released;
+
+                    if (Type == FIX) return { Gesture::InfiniteEnd, 1 };
+
+                    if (presses < UINT8_MAX) presses += 1;
+                    series_end_us = now_us + Timings::multipress_us;
+
+                    return { Gesture::Onetime, presses };
+                }
+                if (Type == NO_FIX && now_us - since_us >= Timings::long_press_us)
+                {
+                    // Long-time press blocks the onetime press and ends the series
+                    state = State::LongPressed;
+                    presses = 0;
+
+                    return { Gesture::LongPress, 1 };
+                }
+                break;
+
+            case State::LongPressed:
+
+                if (!pressed) state = State::Released;
+                break;
+        }
+
+        return { Gesture::None, 0 };
+    }
+
+    // Gesture detection by the direct register read
+    GestureEvent poll()
+    {
+        return update(read(), esp_timer_get_time());
+    }
+
+    // Current state for the UI
+    bool is_pressed() const { return state == State::Pressed || state == State::LongPressed; }
+    uint8_t presses_in_series() const { return presses; }
+
+private:
+
+    enum class State : uint8_t { Released, Debounce, Pressed, LongPressed };
+
+    State state = State::Released;
+    uint8_t presses = 0;                        // Presses of the current series
+    int64_t since_us = 0;                       // Debounce start / debounced press time
+    int64_t series_end_us = 0;                  // Multipress pause end
+};
+
+// =========================================================================================== BUTTON
+
+
+// =========================================================================================== BUTTON BANK
+
+template <typename... Buttons>
+class ButtonBank
+{
+public:
+
+    static_assert(sizeof...(Buttons) > 0, "Empty button bank");
+
+    static constexpr std::size_t size = sizeof...(Buttons);
+
+    // Input registers, used by the bank buttons (the others are not read)
+    static constexpr bool uses_in = ((!Buttons::high_bank) || ...);
+    static constexpr bool uses_in1 = (Buttons::high_bank || ...);
+
+    // All pins configuration: one gpio_config per used pull mode (like button_initialization_bulk)
+    static esp_err_t configure()
+    {
+        for (int pull = 0; pull < 4; pull++)
+        {
+            uint64_t pins = ((Buttons::pull_mode == pull ? Buttons::pin_mask : 0ULL) | ...);
+
+            if (pins == 0) continue;
+
+            gpio_config_t config = {};
+
+            config.pin_bit_mask = pins;
+            config.mode = GPIO_MODE_INPUT;
+            config.pull_up_en = (pull == GPIO_PULLUP_ONLY || pull == GPIO_PULLUP_PULLDOWN) ? GPIO_PULLUP_ENABLE
+                                                                                           : GPIO_PULLUP_DISABLE;
+            config.pull_down_en = (pull == GPIO_PULLDOWN_ONLY || pull == GPIO_PULLUP_PULLDOWN) ? GPIO_PULLDOWN_ENABLE
+                                                                                               : GPIO_PULLDOWN_DISABLE;
+            config.intr_type = GPIO_INTR_DISABLE;
+
+            esp_err_t error = gpio_config(&config);
+
+            if (error != ESP_OK) return error;
+        }
+
+        return ESP_OK;
+    }
+
+    // One read of the used input registers
+    static button_bank_snapshot sample()
+    {
+        button_bank_snapshot bank = { 0, 0 };
+
+        if constexpr (uses_in) bank.in = REG_READ(GPIO_IN_REG);
+#if BUTTON_GPIO_HIGH_BANK
+        if constexpr (uses_in1) bank.in1 = REG_READ(GPIO_IN1_REG);
+#endif
+
+        return bank;
+    }
+
+    // All buttons by one sample: handler(index, event) is called for every detected gesture
+    template <typename Handler>
+    void poll(Handler &&handler)
+    {
+        update(sample(), esp_timer_get_time(), handler);
+    }
+
+    // All buttons by the own snapshot and time (button_bank_sample, trace replay, simulations)
+    template <typename Handler>
+    void update(const button_bank_snapshot &bank, int64_t now_us, Handler &&handler)
+    {
+        update_each(bank, now_us, handler, std::index_sequence_for<Buttons...>{});
+    }
+
+    // Button access by the index
+    template <std::size_t Index>
+    auto &get() { return std::get<Index>(buttons); }
+
+private:
+
+    template <typename Handler, std::size_t... Index>
+    void update_each(const button_bank_snapshot &bank, int64_t now_us, Handler &handler, std::index_sequence<Index...>)
+    {
+        (update_one<Index>(bank, now_us, handler), ...);
+    }
+
+    template <std::size_t Index, typename Handler>
+    void update_one(const button_bank_snapshot &bank, int64_t now_us, Handler &handler)
+    {
+        auto &button = std::get<Index>(buttons);
+        using button_t = std::tuple_element_t<Index, std::tuple<Buttons...>>;
+
+        GestureEvent event = button.update(button_t::level(bank), now_us);
+
+        if (event) handler(Index, event);
+    }
+
+    std::tuple<Buttons...> buttons;
+};
+
+// =========================================================================================== BUTTON BANK
+
+} // namespace button_control
+
+
+#endif // BUTTON_CONTROL_HPP
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+#include <my_libs/button_control/button_control.hpp>
+
+using namespace button_control;
+
+using MenuButton = Button<GPIO_NUM_4>;                                          // Pullup, NO_FIX, C timings
+using OkButton = Button<GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX, Timing<5, 400, 1500>>;
+using LockSwitch = Button<GPIO_NUM_33, GPIO_PULLDOWN_ONLY, FIX>;
+
+static ButtonBank<MenuButton, OkButton, LockSwitch> panel;
+
+extern "C" void app_main()
+{
+    ButtonBank<MenuButton, OkButton, LockSwitch>::configure();
+
+    while (1)
+    {
+        panel.poll([](std::size_t index, GestureEvent event)
+        {
+            if (index == 0 && event.gesture == Gesture::Onetime) show_menu();
+            if (index == 1 && event.gesture == Gesture::Multiple && event.count == 2) confirm();
+            if (index == 1 && event.gesture == Gesture::LongPress) cancel();
+            if (index == 2) lock(event.gesture == Gesture::InfiniteStart);
+        });
+
+        await(1, TIME_UNIT_MS);
+    }
+}
+
+
+// Benchmark against the C version: button_bench_templates (button_control_bench.c with the
+// button_control_bench_templates.cpp), the same simulated presses are passed to the C API and to the
+// ButtonBank, ns per poll of 8 buttons and the detected events of both sides are printed
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
@@ -0,0 +1,1750 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - microbenchmark with bounce models (С-File)
+
+// Author: dimakomplekt
+
+// Description: Simulated buttons with contact models are driven through the button_control APIs by the
+// input source hook. The contact model is evaluated before the measured zone, so ns per tick are the
+// API cost only.
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include "button_control_bench.h"
+#include "button_control_trace.h"               // Replay bench: recorder / virtual replay
+
+#if BUTTON_CONTROL_EVENTS
+    #include "button_control_task.h"            // Handoff bench: event queue
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_cpu.h"                            // For esp_cpu_get_cycle_count()
+#include "esp_rom_sys.h"                        // For esp_rom_get_cpu_ticks_per_us()
+#include "esp_timer.h"                          // For esp_timer_get_time()
+
+#if BUTTON_CONTROL_PROFILER
+    #include "driver/gptimer.h"                 // Flash stall bench: ISR passes
+    #include "esp_heap_caps.h"                  // Flash stall bench: buttons in the internal RAM
+    #include "esp_partition.h"                  // Flash stall bench: flash load
+#endif
+
+#if !BUTTON_CONTROL_SIM_INPUT
+    #error "button_control_bench requires BUTTON_CONTROL_SIM_INPUT 1"
+#endif
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#define BENCH_LONG_PRESS_MS (BUTTON_LONG_PRESS_S * 1000)        // Long-time press await of the library
+#define BENCH_LONG_HOLD_MIN_MS (BENCH_LONG_PRESS_MS + 500)      // Long hold distribution range
+#define BENCH_LONG_HOLD_MAX_MS (BENCH_LONG_PRESS_MS + 2000)
+#define BENCH_BURST_GAP_MS 150                  // Gap between the presses of one burst
+#define BENCH_MIN_IDLE_MS 50                    // Idle gap floor
+#define BENCH_TAIL_MS 4000                      // Quiet tail for the events settle
+#define BENCH_CHATTER_QUANTUM_US 5              // Chatter noise resolution
+#define BENCH_NO_EDGE INT64_MAX                 // No more edges for the button
+#define BENCH_ENCODER_TICKS 4000                // Encoder bench: bank samples per step rate
+#define BENCH_REPLAY_EVENTS_MAX 4096            // Replay bench: events of the recorded run
+#define BENCH_REPLAY_MAX_BUTTONS 32             // Replay bench: buttons on the GPIO_IN_REG bits
+#define BENCH_STALL_BOUNCE_PASSES 4             // Flash stall bench: bouncing ISR passes after every edge
+#define BENCH_STALL_SHORT_PRESS_MS 120          // Flash stall bench: press of the short press APIs
+#define BENCH_STALL_IDLE_MS 280                 // Flash stall bench: release between the presses
+
+// =========================================================================================== DEFINES
+
+
+// =========================================================================================== STRUCTS
+
+// Simulated button state
+typedef struct
+{
+    uint32_t rng;                       // xorshift32 state
+
+    bool pressed;                       // Ideal contact state
+    int64_t last_edge_us;               // Time of the last ideal edge
+    int64_t next_edge_us;               // Time of the next ideal edge
+
+    uint32_t press_ms;                  // Current press duration
+    uint8_t clicks_left;                // Presses left in the current burst
+    bool burst_short;                   // All presses of the current burst are short
+
+    int raw_level;                      // Level for the input source (evaluated before the measured zone)
+    int seen_level;                     // Level at the last pass with the API calls (tickless edge detection)
+
+    bool flag;                          // Controlled flag (flag APIs)
+    bool previous_flag;                 // Flag value after the previous tick
+
+    uint32_t expected;                  // Ground truth events
+    uint32_t detected;                  // Detected events
+
+} bench_button;
+
+// =========================================================================================== STRUCTS
+
+
+// =========================================================================================== VARIABLES
+
+static const button_bench_config *bench_config;     // Current run config
+static bench_button *bench_buttons;                 // Simulated states
+static button_ctx *bench_ctx;                       // Button contexts
+static button_ctx **bench_ctx_list;                 // Button contexts list for the button_next_wakeup_us
+static unsigned int bench_current;                  // Index of the button inside the API call
+
+static const char *bench_api_names[BUT_BENCH_API_QUANTITY] = {
+    "flag_onetime", "flag_multiple", "flag_longtime", "flag_infinite",
+    "callback_onetime", "callback_multiple", "callback_longtime", "callback_infinite"
+};
+
+static const char *bench_model_names[BUT_BOUNCE_QUANTITY] = {
+    "clean", "exponential_chatter", "emi_spikes", "slow_rc"
+};
+
+// =========================================================================================== VARIABLES
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+// Stateless noise for the contact models
+static inline uint32_t bench_hash(uint32_t a, uint32_t b)
+{
+    uint32_t x = a * 0x9E3779B1u ^ b;
+
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+
+    return x;
+}
+
+
+static inline uint32_t bench_random(bench_button *sim)
+{
+    sim->rng ^= sim->rng << 13;
+    sim->rng ^= sim->rng >> 17;
+    sim->rng ^= sim->rng << 5;
+
+    return sim->rng;
+}
+
+
+static inline uint32_t bench_random_range(bench_button *sim, uint32_t min, uint32_t max)
+{
+    if (max <= min) return min;
+
+    return min + bench_random(sim) % (max - min + 1);
+}
+
+
+// Exponential distribution with the selected mean
+static inline uint32_t bench_random_exponential(bench_button *sim, uint32_t mean)
+{
+    float u = ((bench_random(sim) >> 8) + 1) / 16777217.0f;
+
+    return (uint32_t)(-logf(u) * mean);
+}
+
+
+// Ground truth of the finished press for the benchmarked API
+static void bench_count_press(bench_button *sim)
+{
+    bool long_press = (sim->press_ms >= BENCH_LONG_PRESS_MS);
+
+    switch (bench_config->api)
+    {
+        case BUT_BENCH_FLAG_ONETIME:
+        case BUT_BENCH_CALLBACK_ONETIME:
+            if (!long_press) sim->expected += 1;
+            break;
+
+        case BUT_BENCH_FLAG_INFINITE:
+            sim->expected += 1;         // Every press switches the flag while held
+            break;
+
+        case BUT_BENCH_FLAG_LONGTIME:
+        case BUT_BENCH_CALLBACK_LONGTIME:
+        case BUT_BENCH_CALLBACK_INFINITE:
+            if (long_press) sim->expected += 1;
+            break;
+
+        default:
+            if (long_press) sim->burst_short = false;
+            break;
+    }
+}
+
+
+// Press schedule by the human press / hold distribution
+static void bench_schedule(bench_button *sim, int64_t now_us, int64_t generation_end_us)
+{
+    while (now_us >= sim->next_edge_us)
+    {
+        int64_t edge_us = sim->next_edge_us;
+
+        sim->last_edge_us = edge_us;
+
+        if (!sim->pressed)
+        {
+            sim->pressed = true;
+
+            if (bench_random(sim) % 100 < bench_config->long_hold_percent)
+                sim->press_ms = bench_random_range(sim, BENCH_LONG_HOLD_MIN_MS, BENCH_LONG_HOLD_MAX_MS);
+            else
+                sim->press_ms = bench_random_range(sim, bench_config->press_min_ms, bench_config->press_max_ms);
+
+            sim->next_edge_us = edge_us + (int64_t)sim->press_ms * 1000;
+            continue;
+        }
+
+        sim->pressed = false;
+        bench_count_press(sim);
+
+        if (--sim->clicks_left > 0)
+        {
+            sim->next_edge_us = edge_us + BENCH_BURST_GAP_MS * 1000;
+            continue;
+        }
+
+        // Burst end
+        if ((bench_config->api == BUT_BENCH_FLAG_MULTIPLE || bench_config->api == BUT_BENCH_CALLBACK_MULTIPLE) &&
+            sim->burst_short)
+        {
+            sim->expected += 1;
+        }
+
+        sim->clicks_left = bench_config->clicks_per_burst;
+        sim->burst_short = true;
+
+        uint32_t idle_ms = bench_random_exponential(sim, bench_config->idle_mean_ms);
+        if (idle_ms < BENCH_MIN_IDLE_MS) idle_ms = BENCH_MIN_IDLE_MS;
+
+        sim->next_edge_us = edge_us + (int64_t)idle_ms * 1000;
+
+        if (sim->next_edge_us >= generation_end_us) sim->next_edge_us = BENCH_NO_EDGE;
+    }
+}
+
+
+// Contact model: logical (pressed) level of the button at the time
+static int bench_contact_level(bench_button *sim, unsigned int index, int64_t now_us)
+{
+    int ideal = sim->pressed;
+    uint32_t since_edge_us = (uint32_t)(now_us - sim->last_edge_us);
+    uint32_t bounce_us = bench_config->bounce_us ? bench_config->bounce_us : 1;
+
+    switch (bench_config->bounce_model)
+    {
+        case BUT_BOUNCE_EXPONENTIAL_CHATTER:
+        {
+            if (since_edge_us >= 8 * bounce_us) return ideal;
+
+            float wrong_probability = 0.5f * expf(-(float)since_edge_us / bounce_us);
+            uint32_t noise = bench_hash(index, (uint32_t)(now_us / BENCH_CHATTER_QUANTUM_US));
+
+            return (noise < (uint32_t)(wrong_probability * 4294967295.0f)) ? !ideal : ideal;
+        }
+
+        case BUT_BOUNCE_EMI_SPIKES:
+        {
+            uint32_t width_us = bench_config->spike_width_us ? bench_config->spike_width_us : 1;
+            float spike_probability = (float)bench_config->spikes_per_s * width_us / 1000000.0f;
+            uint32_t noise = bench_hash(index ^ 0xA5A5A5A5u, (uint32_t)(now_us / width_us));
+
+            return (noise < (uint32_t)(spike_probability * 4294967295.0f)) ? !ideal : ideal;
+        }
+
+        case BUT_BOUNCE_SLOW_RC:
+        {
+            // Remaining part of the old level, the input is undefined in 0.4 .. 0.6 of the swing
+            float old_part = expf(-(float)since_edge_us / bounce_us);
+
+            if (old_part > 0.6f) return !ideal;
+            if (old_part < 0.4f) return ideal;
+
+            return bench_hash(index, (uint32_t)(now_us / BENCH_CHATTER_QUANTUM_US)) & 0x1;
+        }
+
+        default: return ideal;
+    }
+}
+
+
+// Simulated button start state (released, first press after the random idle gap)
+static void bench_sim_reset(bench_button *sim, const button_bench_config *config, unsigned int index, int64_t start_us)
+{
+    *sim = (bench_button){ 0 };
+
+    sim->rng = bench_hash(config->seed, index) | 1;
+    sim->clicks_left = config->clicks_per_burst;
+    sim->burst_short = true;
+    sim->last_edge_us = start_us;
+    sim->next_edge_us = start_us + bench_random_exponential(sim, config->idle_mean_ms) * 1000LL;
+    sim->raw_level = 1;     // Pullup - released
+    sim->seen_level = 1;
+}
+
+
+// Simulated input source for the button_control
+static int bench_input_source(const button_ctx *button)
+{
+    return bench_buttons[button - bench_ctx].raw_level;
+}
+
+
+// Simulated bank (replay / templates benches): button i is the bit i of GPIO_IN_REG, all other pins are released
+static void bench_bank_source(button_bank_snapshot *snapshot)
+{
+    snapshot->in = 0xFFFFFFFF;
+    snapshot->in1 = 0xFFFFFFFF;
+
+    for (unsigned int i = 0; i < bench_config->buttons_quantity; i++)
+    {
+        if (!bench_buttons[i].raw_level) snapshot->in &= ~(1UL << i);
+    }
+}
+
+
+// Buttons of the replay / templates benches: template copies on the pins 0..N-1 (levels come from the bank only)
+static void bench_bank_buttons_reset(const button_ctx *template_button)
+{
+    for (unsigned int i = 0; i < bench_config->buttons_quantity; i++)
+    {
+        bench_ctx[i] = *template_button;
+        bench_ctx[i].PIN = (gpio_num_t)i;
+
+        bench_buttons[i].flag = false;
+        bench_buttons[i].previous_flag = false;
+    }
+}
+
+
+#if BUTTON_CONTROL_CALLBACKS
+
+// Callback for all the callback APIs
+static void BUT_IRAM_ATTR bench_callback(void)
+{
+    bench_buttons[bench_current].detected += 1;
+}
+
+#endif
+
+
+// One API call for the button
+static inline void bench_api_call(button_ctx *button, bench_button *sim)
+{
+    switch (bench_config->api)
+    {
+        case BUT_BENCH_FLAG_ONETIME: flag_control_by_but_onetime_press(button, &sim->flag); break;
+        case BUT_BENCH_FLAG_INFINITE: flag_control_by_but_infinite_press(button, &sim->flag); break;
+
+#if BUTTON_CONTROL_MULTIPRESS
+        case BUT_BENCH_FLAG_MULTIPLE: flag_control_by_but_multiple_press(button, &sim->flag, bench_config->clicks_per_burst); break;
+#endif
+
+#if BUTTON_CONTROL_LONG_PRESS
+        case BUT_BENCH_FLAG_LONGTIME: flag_control_by_but_longtime_press(button, &sim->flag); break;
+#endif
+
+#if BUTTON_CONTROL_CALLBACKS
+        case BUT_BENCH_CALLBACK_ONETIME: callback_control_by_but_onetime_press(button, 1); break;
+
+#if BUTTON_CONTROL_MULTIPRESS
+        case BUT_BENCH_CALLBACK_MULTIPLE: callback_control_by_but_multiple_press(button, bench_config->clicks_per_burst, 1); break;
+#endif
+
+#if BUTTON_CONTROL_LONG_PRESS
+        case BUT_BENCH_CALLBACK_LONGTIME: callback_control_by_but_longtime_press(button, 1); break;
+        case BUT_BENCH_CALLBACK_INFINITE: callback_control_by_but_infinite_press(button, 1); break;
+#endif
+#endif // BUTTON_CONTROL_CALLBACKS
+
+        default: break;
+    }
+}
+
+
+// Config check of the runs
+static bool bench_config_valid(const button_bench_config *config)
+{
+    if (config->buttons_quantity < 1 || config->buttons_quantity > BUT_BENCH_MAX_BUTTONS) return false;
+    if (config->api >= BUT_BENCH_API_QUANTITY || config->bounce_model >= BUT_BOUNCE_QUANTITY) return false;
+    if (config->clicks_per_burst < 1) return false;
+
+#if !BUTTON_CONTROL_WAKEUP
+    if (config->tickless) return false;
+#endif
+
+#if !BUTTON_CONTROL_MULTIPRESS
+    if (config->api == BUT_BENCH_FLAG_MULTIPLE || config->api == BUT_BENCH_CALLBACK_MULTIPLE) return false;
+#endif
+
+#if !BUTTON_CONTROL_LONG_PRESS
+    if (config->api == BUT_BENCH_FLAG_LONGTIME || config->api == BUT_BENCH_CALLBACK_LONGTIME ||
+        config->api == BUT_BENCH_CALLBACK_INFINITE) return false;
+#endif
+
+#if !BUTTON_CONTROL_CALLBACKS
+    if (config->api >= BUT_BENCH_CALLBACK_ONETIME) return false;
+#endif
+
+    return true;
+}
+
+
+// Template button of the runs with the bench callback for all callback APIs
+static button_ctx bench_template_button(gpio_num_t PIN)
+{
+    button_ctx template_button = button_initialization(PIN, GPIO_PULLUP_ONLY, NO_FIX);
+
+#if BUTTON_CONTROL_CALLBACKS
+    template_button.onetime_press_callback = bench_callback;
+#if BUTTON_CONTROL_MULTIPRESS
+    template_button.multiple_press_callback = bench_callback;
+#endif
+#if BUTTON_CONTROL_LONG_PRESS
+    template_button.long_time_press_callback = bench_callback;
+    template_button.infinite_press_callback = bench_callback;
+#endif
+#endif
+
+    return template_button;
+}
+
+
+#if BUTTON_CONTROL_PROFILER
+
+// Flash stall bench: the ISR pattern and statistics (internal RAM, read by the ISR with the disabled cache)
+static BUT_DRAM_ATTR volatile uint32_t stall_passes;
+static BUT_DRAM_ATTR uint32_t stall_press_passes;       // Press length in passes
+static BUT_DRAM_ATTR uint32_t stall_cycle_passes;       // Press + release length in passes
+static BUT_DRAM_ATTR uint32_t stall_pass_max_cycles;    // Longest ISR pass
+static BUT_DRAM_ATTR uint32_t stall_gap_max_cycles;     // Longest time between the ISR pass starts
+static BUT_DRAM_ATTR uint32_t stall_last_start;
+
+static volatile bool stall_flash_stop;
+static volatile bool stall_flash_done;
+static uint32_t stall_flash_ops;
+
+
+// ISR input: staggered presses with the bouncing passes after both edges (integer pattern, no tables)
+static int BUT_IRAM_ATTR bench_stall_input(const button_ctx *button)
+{
+    uint32_t phase = (stall_passes + (uint32_t)(button - bench_ctx) * 37) % stall_cycle_passes;
+    uint32_t since_edge = (phase < stall_press_passes) ? phase : phase - stall_press_passes;
+    int pressed = (phase < stall_press_passes);
+
+    if (since_edge < BENCH_STALL_BOUNCE_PASSES && (since_edge & 0x1)) pressed = !pressed;
+
+    return !pressed;    // Pullup
+}
+
+
+// One API call for the button from the ISR (compares instead of the switch - no jump table in the flash)
+static inline void BUT_IRAM_ATTR bench_stall_api_call(button_ctx *button, bench_button *sim)
+{
+    button_bench_api api = bench_config->api;
+
+    if (api == BUT_BENCH_FLAG_ONETIME) flag_control_by_but_onetime_press(button, &sim->flag);
+    else if (api == BUT_BENCH_FLAG_INFINITE) flag_control_by_but_infinite_press(button, &sim->flag);
+#if BUTTON_CONTROL_MULTIPRESS
+    else if (api == BUT_BENCH_FLAG_MULTIPLE) flag_control_by_but_multiple_press(button, &sim->flag, bench_config->clicks_per_burst);
+#endif
+#if BUTTON_CONTROL_LONG_PRESS
+    else if (api == BUT_BENCH_FLAG_LONGTIME) flag_control_by_but_longtime_press(button, &sim->flag);
+#endif
+#if BUTTON_CONTROL_CALLBACKS
+    else if (api == BUT_BENCH_CALLBACK_ONETIME) callback_control_by_but_onetime_press(button, 1);
+#if BUTTON_CONTROL_MULTIPRESS
+    else if (api == BUT_BENCH_CALLBACK_MULTIPLE) callback_control_by_but_multiple_press(button, bench_config->clicks_per_burst, 1);
+#endif
+#if BUTTON_CONTROL_LONG_PRESS
+    else if (api == BUT_BENCH_CALLBACK_LONGTIME) callback_control_by_but_longtime_press(button, 1);
+    else if (api == BUT_BENCH_CALLBACK_INFINITE) callback_control_by_but_infinite_press(button, 1);
+#endif
+#endif
+}
+
+
+// Timer ISR: one pass over all the buttons
+static bool BUT_IRAM_ATTR bench_stall_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *user)
+{
+    uint32_t pass_start = (uint32_t)esp_cpu_get_cycle_count();
+
+    if (stall_passes > 0 && pass_start - stall_last_start > stall_gap_max_cycles)
+        stall_gap_max_cycles = pass_start - stall_last_start;
+
+    stall_last_start = pass_start;
+
+    for (bench_current = 0; bench_current < bench_config->buttons_quantity; bench_current++)
+    {
+        bench_stall_api_call(&bench_ctx[bench_current], &bench_buttons[bench_current]);
+    }
+
+    uint32_t pass_cycles = (uint32_t)esp_cpu_get_cycle_count() - pass_start;
+
+    if (pass_cycles > stall_pass_max_cycles) stall_pass_max_cycles = pass_cycles;
+
+    stall_passes += 1;
+
+    return false;       // No task is woken
+}
+
+
+// Flash load: erase + write of the scratch partition sector (cache is disabled during every operation)
+static void bench_flash_load(void *parameter)
+{
+    const esp_partition_t *partition = (const esp_partition_t *)parameter;
+    uint8_t data[256];
+
+    memset(data, 0xA5, sizeof(data));
+
+    while (!stall_flash_stop)
+    {
+        if (esp_partition_erase_range(partition, 0, partition->erase_size) == ESP_OK &&
+            esp_partition_write(partition, 0, data, sizeof(data)) == ESP_OK)
+        {
+            stall_flash_ops += 1;
+        }
+
+        vTaskDelay(1);      // IDLE task of the core for its watchdog
+    }
+
+    stall_flash_done = true;
+    vTaskDelete(NULL);
+}
+
+#endif // BUTTON_CONTROL_PROFILER
+
+
+#if BUTTON_CONTROL_ENCODER
+
+// Encoder bench: simulated quadrature signal (simulated clock, no real time)
+static button_encoder bench_encoder;
+static int64_t encoder_time_us;                 // Simulated time of the next bank sample
+static uint32_t encoder_rate;                   // Steps per second
+static uint32_t encoder_b_shift;                // B edges delay, millionths of the 4-step cycle / 4
+
+
+// Quadrature levels at the simulated time: A high in [2, 4), B high in [1, 3) steps of the cycle,
+// B edges are delayed by the phase error (adjacent edges get closer)
+static void bench_encoder_levels(int *A, int *B)
+{
+    uint32_t cycle = (uint32_t)(((uint64_t)encoder_time_us * encoder_rate) % 4000000);
+
+    *A = (cycle >= 2000000);
+    *B = (cycle >= 1000000 + encoder_b_shift && cycle < 3000000 + encoder_b_shift);
+}
+
+
+static void bench_encoder_bit_set(button_bank_snapshot *snapshot, gpio_num_t PIN, int level)
+{
+    uint32_t *word = (PIN < BUTTON_GPIO_LOW_BANK_PINS) ? &snapshot->in : &snapshot->in1;
+    uint32_t bit = 1UL << (PIN % BUTTON_GPIO_LOW_BANK_PINS);
+
+    if (level) *word |= bit;
+    else *word &= ~bit;
+}
+
+
+// Simulated bank source: released pullup buttons + the encoder channels
+static void bench_encoder_bank_source(button_bank_snapshot *snapshot)
+{
+    int A, B;
+
+    bench_encoder_levels(&A, &B);
+
+    snapshot->in = 0xFFFFFFFF;
+    snapshot->in1 = 0xFFFFFFFF;
+
+    bench_encoder_bit_set(snapshot, bench_encoder.PIN_A, A);
+    bench_encoder_bit_set(snapshot, bench_encoder.PIN_B, B);
+}
+
+#endif // BUTTON_CONTROL_ENCODER
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Replay bench: virtual clock, events of the recorded run and the comparison of the replay
+static int64_t replay_clock_us;
+static button_event *replay_events;
+static uint32_t replay_events_quantity;         // Recorded events
+static uint32_t replay_events_position;         // Next recorded event to compare with
+static uint32_t replay_mismatches;
+static bool replay_recording;
+
+
+static int64_t bench_replay_clock(void)
+{
+    return replay_clock_us;
+}
+
+
+static bool bench_replay_event_same(const button_event *a, const button_event *b)
+{
+    return a->PIN == b->PIN && a->type == b->type && a->count == b->count &&
+           a->hold_ms == b->hold_ms && a->time_us == b->time_us;
+}
+
+
+// Recording: store the events, replay: compare them with the recorded ones in order
+static void bench_replay_listener(const button_event *event, void *user)
+{
+    (void)user;
+
+    if (replay_recording)
+    {
+        if (replay_events_quantity < BENCH_REPLAY_EVENTS_MAX) replay_events[replay_events_quantity++] = *event;
+        return;
+    }
+
+    if (replay_events_position >= replay_events_quantity ||
+        !bench_replay_event_same(&replay_events[replay_events_position], event)) replay_mismatches += 1;
+
+    replay_events_position += 1;
+}
+
+
+#endif // BUTTON_CONTROL_EVENTS
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== API REALIZATION
+
+button_bench_config button_bench_config_default(gpio_num_t PIN, button_bench_api api)
+{
+    button_bench_config config;
+
+    config.PIN = PIN;
+
+    config.api = api;
+    config.buttons_quantity = 64;
+
+    config.bounce_model = BUT_BOUNCE_EXPONENTIAL_CHATTER;
+    config.bounce_us = 300;
+    config.spike_width_us = 20;
+    config.spikes_per_s = 5;
+
+    config.press_min_ms = 60;
+    config.press_max_ms = 250;
+    config.long_hold_percent = 10;
+    config.idle_mean_ms = 700;
+    config.clicks_per_burst = (api == BUT_BENCH_FLAG_MULTIPLE || api == BUT_BENCH_CALLBACK_MULTIPLE) ? 2 : 1;
+
+    config.tickless = false;
+
+    config.duration_ms = 20000;
+    config.seed = 0x12345678u;
+
+    return config;
+}
+
+
+bool button_bench_run(const button_bench_config *config, button_bench_result *result)
+{
+    // Error handler
+    if (!bench_config_valid(config)) return false;
+
+    bench_buttons = calloc(config->buttons_quantity, sizeof(bench_button));
+    bench_ctx = calloc(config->buttons_quantity, sizeof(button_ctx));
+    bench_ctx_list = calloc(config->buttons_quantity, sizeof(button_ctx *));
+
+    if (bench_buttons == NULL || bench_ctx == NULL || bench_ctx_list == NULL)
+    {
+        free(bench_buttons);
+        free(bench_ctx);
+        free(bench_ctx_list);
+
+        return false;
+    }
+
+    bench_config = config;
+
+    // All buttons are copies of one template button, the pin is configured once
+    button_ctx template_button = bench_template_button(config->PIN);
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t generation_end_us = start_us + (int64_t)config->duration_ms * 1000;
+    int64_t end_us = generation_end_us + BENCH_TAIL_MS * 1000;
+
+    for (unsigned int i = 0; i < config->buttons_quantity; i++)
+    {
+        bench_ctx[i] = template_button;
+        bench_ctx_list[i] = &bench_ctx[i];
+
+        bench_sim_reset(&bench_buttons[i], config, i, start_us);
+    }
+
+    button_input_source_set(bench_input_source);
+
+    uint64_t ticks = 0;
+    uint64_t awake_ticks = 0;
+    uint64_t api_cycles = 0;
+    uint32_t wakeups = 0;
+    int64_t now_us;
+
+    bool sleeping = false;
+    int64_t sleep_until_us = 0;
+
+    while ((now_us = esp_timer_get_time()) < end_us)
+    {
+        bool edge = false;
+
+        // Contact models (out of the measured zone)
+        for (unsigned int i = 0; i < config->buttons_quantity; i++)
+        {
+            bench_schedule(&bench_buttons[i], now_us, generation_end_us);
+
+            bench_buttons[i].raw_level = !bench_contact_level(&bench_buttons[i], i, now_us);
+
+            if (bench_buttons[i].raw_level != bench_buttons[i].seen_level) edge = true;
+        }
+
+        ticks += 1;
+
+        // Tickless: stay asleep until the pin edge or the deadline
+        if (sleeping)
+        {
+            if (!edge && now_us < sleep_until_us) continue;
+
+            sleeping = false;
+            wakeups += 1;
+        }
+
+        // Measured zone
+        uint32_t cycles_start = (uint32_t)esp_cpu_get_cycle_count();
+
+        for (bench_current = 0; bench_current < config->buttons_quantity; bench_current++)
+        {
+            bench_api_call(&bench_ctx[bench_current], &bench_buttons[bench_current]);
+        }
+
+        api_cycles += (uint32_t)esp_cpu_get_cycle_count() - cycles_start;
+        awake_ticks += 1;
+
+        for (unsigned int i = 0; i < config->buttons_quantity; i++)
+        {
+            bench_buttons[i].seen_level = bench_buttons[i].raw_level;
+        }
+
+#if BUTTON_CONTROL_WAKEUP
+        if (config->tickless)
+        {
+            int64_t next_us = button_next_wakeup_us(bench_ctx_list, config->buttons_quantity);
+
+            if (next_us != 0)
+            {
+                sleeping = true;
+                sleep_until_us = (next_us == BUTTON_WAKEUP_ON_EDGE) ? INT64_MAX : now_us + next_us;
+            }
+        }
+#endif
+
+        // Flag events detection
+        if (config->api <= BUT_BENCH_FLAG_INFINITE)
+        {
+            for (unsigned int i = 0; i < config->buttons_quantity; i++)
+            {
+                bench_button *sim = &bench_buttons[i];
+
+                if (sim->flag != sim->previous_flag)
+                {
+                    // Infinite press flag returns back on release - count the press side only
+                    if (config->api != BUT_BENCH_FLAG_INFINITE || sim->flag) sim->detected += 1;
+
+                    sim->previous_flag = sim->flag;
+                }
+            }
+        }
+    }
+
+    button_input_source_set(NULL);
+
+    // Result
+    *result = (button_bench_result){ 0 };
+
+    result->ticks = ticks;
+    result->awake_ticks = awake_ticks;
+    result->elapsed_us = (uint64_t)(now_us - start_us);
+    result->api_us = api_cycles / esp_rom_get_cpu_ticks_per_us();
+
+    if (awake_ticks > 0)
+    {
+        result->ns_per_tick = (uint32_t)(result->api_us * 1000 / awake_ticks);
+        result->ns_per_button = result->ns_per_tick / config->buttons_quantity;
+    }
+
+    result->wakeups = wakeups;
+
+    if (result->elapsed_us > 0)
+        result->wakeups_per_hour = (uint32_t)((uint64_t)wakeups * 3600000000ULL / result->elapsed_us);
+
+    for (unsigned int i = 0; i < config->buttons_quantity; i++)
+    {
+        bench_button *sim = &bench_buttons[i];
+
+        result->expected_events += sim->expected;
+        result->detected_events += sim->detected;
+
+        if (sim->detected > sim->expected) result->false_events += sim->detected - sim->expected;
+        else result->missed_events += sim->expected - sim->detected;
+    }
+
+    if (result->elapsed_us > 0)
+        result->events_per_s = (uint32_t)((uint64_t)result->detected_events * 1000000 / result->elapsed_us);
+
+#if BUTTON_CONTROL_HEALTH
+    uint64_t bounce_total_us = 0;
+    uint32_t transitions = 0;
+
+    for (unsigned int i = 0; i < config->buttons_quantity; i++)
+    {
+        button_health_report report;
+
+        button_health_snapshot(&bench_ctx_list[i], 1, &report);
+
+        result->health_presses += report.stats.presses;
+        result->chatter_rejected += report.stats.chatter_rejected;
+
+        if (report.stats.bounce_max_us > result->bounce_max_us) result->bounce_max_us = report.stats.bounce_max_us;
+
+        bounce_total_us += report.stats.bounce_total_us;
+        transitions += report.stats.transitions;
+    }
+
+    if (transitions > 0) result->bounce_mean_us = (uint32_t)(bounce_total_us / transitions);
+#endif
+
+    free(bench_buttons);
+    free(bench_ctx);
+    free(bench_ctx_list);
+
+    bench_buttons = NULL;
+    bench_ctx = NULL;
+    bench_ctx_list = NULL;
+
+    return true;
+}
+
+
+void button_bench_print_result(const button_bench_config *config, const button_bench_result *result)
+{
+    float expected = result->expected_events ? (float)result->expected_events : 1.0f;
+
+    printf("{\"bench\":\"button_control\",\"api\":\"%s\",\"model\":\"%s\",\"buttons\":%u,"
+           "\"bounce_us\":%u,\"duration_ms\":%u,\"seed\":%u,"
+           "\"ticks\":%llu,\"ns_per_tick\":%u,\"ns_per_button\":%u,\"events_per_s\":%u,"
+           "\"expected\":%u,\"detected\":%u,\"false\":%u,\"missed\":%u,"
+           "\"false_rate\":%.4f,\"missed_rate\":%.4f,"
+           "\"tickless\":%s,\"awake_ticks\":%llu,\"wakeups\":%u,\"wakeups_per_hour\":%u",
+           bench_api_names[config->api], bench_model_names[config->bounce_model], config->buttons_quantity,
+           (unsigned)config->bounce_us, (unsigned)config->duration_ms, (unsigned)config->seed,
+           (unsigned long long)result->ticks, (unsigned)result->ns_per_tick, (unsigned)result->ns_per_button,
+           (unsigned)result->events_per_s,
+           (unsigned)result->expected_events, (unsigned)result->detected_events,
+           (unsigned)result->false_events, (unsigned)result->missed_events,
+           result->false_events / expected, result->missed_events / expected,
+           config->tickless ? "true" : "false", (unsigned long long)result->awake_ticks,
+           (unsigned)result->wakeups, (unsigned)result->wakeups_per_hour);
+
+#if BUTTON_CONTROL_HEALTH
+    printf(",\"health_presses\":%u,\"chatter_rejected\":%u,\"bounce_mean_us\":%u,\"bounce_max_us\":%u",
+           (unsigned)result->health_presses, (unsigned)result->chatter_rejected,
+           (unsigned)result->bounce_mean_us, (unsigned)result->bounce_max_us);
+#endif
+
+    printf("}\n");
+}
+
+
+
+bool button_bench_startup(const gpio_num_t *pins, size_t pins_quantity, unsigned int buttons_quantity)
+{
+    // Error handler
+    if (pins == NULL || pins_quantity == 0 || buttons_quantity < 1 || buttons_quantity > BUT_BENCH_MAX_BUTTONS)
+        return false;
+
+    button_ctx *buttons = calloc(buttons_quantity, sizeof(button_ctx));
+    button_config *configs = calloc(buttons_quantity, sizeof(button_config));
+
+    if (buttons == NULL || configs == NULL)
+    {
+        free(buttons);
+        free(configs);
+
+        return false;
+    }
+
+    for (unsigned int i = 0; i < buttons_quantity; i++)
+    {
+        configs[i].PIN = pins[i % pins_quantity];
+        configs[i].pull_mode = GPIO_PULLUP_ONLY;
+        configs[i].type = NO_FIX;
+    }
+
+    // By value, pin by pin
+    uint32_t cycles_start = (uint32_t)esp_cpu_get_cycle_count();
+
+    for (unsigned int i = 0; i < buttons_quantity; i++)
+    {
+        buttons[i] = button_initialization(configs[i].PIN, configs[i].pull_mode, configs[i].type);
+    }
+
+    uint32_t legacy_cycles = (uint32_t)esp_cpu_get_cycle_count() - cycles_start;
+
+    // In place, pin masks
+    cycles_start = (uint32_t)esp_cpu_get_cycle_count();
+
+    esp_err_t error = button_initialization_bulk(buttons, configs, buttons_quantity);
+
+    uint32_t bulk_cycles = (uint32_t)esp_cpu_get_cycle_count() - cycles_start;
+
+    printf("{\"bench\":\"button_control_startup\",\"buttons\":%u,\"ctx_bytes\":%u,"
+           "\"initialization_cycles\":%u,\"bulk_cycles\":%u,\"bulk_status\":%d}\n",
+           buttons_quantity, (unsigned)sizeof(button_ctx), (unsigned)legacy_cycles, (unsigned)bulk_cycles, (int)error);
+
+    free(buttons);
+    free(configs);
+
+    return true;
+}
+
+
+bool button_bench_templates(const button_bench_config *config)
+{
+    // Error handler
+    if (config->api != BUT_BENCH_FLAG_ONETIME && config->api != BUT_BENCH_FLAG_LONGTIME) return false;
+
+    // Fixed bank of the C++ side
+    button_bench_config templates_config = *config;
+    templates_config.buttons_quantity = BUT_BENCH_TEMPLATES_BUTTONS;
+    templates_config.tickless = false;
+
+    if (!bench_config_valid(&templates_config)) return false;
+
+    bench_buttons = calloc(BUT_BENCH_TEMPLATES_BUTTONS, sizeof(bench_button));
+    bench_ctx = calloc(BUT_BENCH_TEMPLATES_BUTTONS, sizeof(button_ctx));
+
+    if (bench_buttons == NULL || bench_ctx == NULL)
+    {
+        free(bench_buttons);
+        free(bench_ctx);
+
+        bench_buttons = NULL;
+        bench_ctx = NULL;
+
+        return false;
+    }
+
+    bench_config = &templates_config;
+
+    button_ctx template_button = bench_template_button(config->PIN);
+
+    bench_bank_buttons_reset(&template_button);
+    button_bench_templates_reset();
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t generation_end_us = start_us + (int64_t)config->duration_ms * 1000;
+    int64_t end_us = generation_end_us + BENCH_TAIL_MS * 1000;
+
+    for (unsigned int i = 0; i < BUT_BENCH_TEMPLATES_BUTTONS; i++)
+    {
+        bench_sim_reset(&bench_buttons[i], &templates_config, i, start_us);
+    }
+
+    button_bank_source_set(bench_bank_source);
+
+    uint32_t cpp_onetime[BUT_BENCH_TEMPLATES_BUTTONS] = { 0 };
+    uint32_t cpp_long_press[BUT_BENCH_TEMPLATES_BUTTONS] = { 0 };
+
+    uint64_t ticks = 0;
+    uint64_t c_cycles = 0;
+    uint64_t cpp_cycles = 0;
+    int64_t now_us;
+
+    while ((now_us = esp_timer_get_time()) < end_us)
+    {
+        // Contact models and the bank sample (out of the measured zones, shared by both sides)
+        for (unsigned int i = 0; i < BUT_BENCH_TEMPLATES_BUTTONS; i++)
+        {
+            bench_schedule(&bench_buttons[i], now_us, generation_end_us);
+            bench_buttons[i].raw_level = !bench_contact_level(&bench_buttons[i], i, now_us);
+        }
+
+        const button_bank_snapshot *bank = button_bank_sample();
+
+        // C API zone
+        uint32_t cycles_start = (uint32_t)esp_cpu_get_cycle_count();
+
+        for (bench_current = 0; bench_current < BUT_BENCH_TEMPLATES_BUTTONS; bench_current++)
+        {
+            bench_api_call(&bench_ctx[bench_current], &bench_buttons[bench_current]);
+        }
+
+        c_cycles += (uint32_t)esp_cpu_get_cycle_count() - cycles_start;
+
+        // C++ templates zone (own time read, like ButtonBank::poll)
+        cycles_start = (uint32_t)esp_cpu_get_cycle_count();
+
+        button_bench_templates_update(bank, esp_timer_get_time(), cpp_onetime, cpp_long_press);
+
+        cpp_cycles += (uint32_t)esp_cpu_get_cycle_count() - cycles_start;
+
+        ticks += 1;
+
+        // C flag events
+        for (unsigned int i = 0; i < BUT_BENCH_TEMPLATES_BUTTONS; i++)
+        {
+            bench_button *sim = &bench_buttons[i];
+
+            if (sim->flag != sim->previous_flag)
+            {
+                sim->detected += 1;
+                sim->previous_flag = sim->flag;
+            }
+        }
+    }
+
+    button_bank_source_set(NULL);
+
+    // Result: both sides against the same press schedule
+    uint32_t expected = 0;
+    uint32_t c_detected = 0, c_false = 0, c_missed = 0;
+    uint32_t cpp_detected = 0, cpp_false = 0, cpp_missed = 0;
+
+    for (unsigned int i = 0; i < BUT_BENCH_TEMPLATES_BUTTONS; i++)
+    {
+        bench_button *sim = &bench_buttons[i];
+        uint32_t cpp = (config->api == BUT_BENCH_FLAG_ONETIME) ? cpp_onetime[i] : cpp_long_press[i];
+
+        expected += sim->expected;
+        c_detected += sim->detected;
+        cpp_detected += cpp;
+
+        if (sim->detected > sim->expected) c_false += sim->detected - sim->expected;
+        else c_missed += sim->expected - sim->detected;
+
+        if (cpp > sim->expected) cpp_false += cpp - sim->expected;
+        else cpp_missed += sim->expected - cpp;
+    }
+
+    uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+
+    printf("{\"bench\":\"button_control_templates\",\"api\":\"%s\",\"model\":\"%s\",\"buttons\":%u,"
+           "\"ticks\":%llu,\"c_ns_per_tick\":%u,\"cpp_ns_per_tick\":%u,\"expected\":%u,"
+           "\"c_detected\":%u,\"c_false\":%u,\"c_missed\":%u,"
+           "\"cpp_detected\":%u,\"cpp_false\":%u,\"cpp_missed\":%u}\n",
+           bench_api_names[config->api], bench_model_names[config->bounce_model], BUT_BENCH_TEMPLATES_BUTTONS,
+           (unsigned long long)ticks,
+           ticks ? (unsigned)(c_cycles * 1000 / cycles_per_us / ticks) : 0u,
+           ticks ? (unsigned)(cpp_cycles * 1000 / cycles_per_us / ticks) : 0u,
+           (unsigned)expected, (unsigned)c_detected, (unsigned)c_false, (unsigned)c_missed,
+           (unsigned)cpp_detected, (unsigned)cpp_false, (unsigned)cpp_missed);
+
+    free(bench_buttons);
+    free(bench_ctx);
+
+    bench_buttons = NULL;
+    bench_ctx = NULL;
+
+    return true;
+}
+
+
+#if BUTTON_CONTROL_HEALTH && BUTTON_CONTROL_WAKEUP
+
+bool button_bench_health_tickless(const button_bench_config *config)
+{
+    button_bench_config run_config = *config;
+    button_bench_result ticked;
+    button_bench_result tickless;
+
+    // The same press schedule (seed) polled every pass and polled by the wakeup deadlines only
+    run_config.tickless = false;
+    if (!button_bench_run(&run_config, &ticked)) return false;
+
+    run_config.tickless = true;
+    if (!button_bench_run(&run_config, &tickless)) return false;
+
+    // Every press must be settled in the tickless loop as well (an unsettled level is not a chatter)
+    bool same = (tickless.health_presses == ticked.health_presses);
+
+    printf("{\"bench\":\"button_control_health_tickless\",\"api\":\"%s\",\"model\":\"%s\",\"buttons\":%u,"
+           "\"expected\":%u,\"ticked_presses\":%u,\"tickless_presses\":%u,"
+           "\"ticked_chatter\":%u,\"tickless_chatter\":%u,\"ticked_bounce_mean_us\":%u,\"tickless_bounce_mean_us\":%u,"
+           "\"awake_ticks\":%llu,\"wakeups_per_hour\":%u,\"same\":%s}\n",
+           bench_api_names[config->api], bench_model_names[config->bounce_model], config->buttons_quantity,
+           (unsigned)ticked.expected_events, (unsigned)ticked.health_presses, (unsigned)tickless.health_presses,
+           (unsigned)ticked.chatter_rejected, (unsigned)tickless.chatter_rejected,
+           (unsigned)ticked.bounce_mean_us, (unsigned)tickless.bounce_mean_us,
+           (unsigned long long)tickless.awake_ticks, (unsigned)tickless.wakeups_per_hour, same ? "true" : "false");
+
+    return same;
+}
+
+#endif // BUTTON_CONTROL_HEALTH && BUTTON_CONTROL_WAKEUP
+
+
+#if BUTTON_CONTROL_PROFILER
+
+bool button_bench_flash_stall(const button_bench_config *config, const char *scratch_label, uint32_t period_us)
+{
+    // Error handler
+    if (!bench_config_valid(config) || period_us < 100) return false;
+
+#if !BUTTON_CONTROL_IRAM
+    // ISR from the flash would run with the disabled cache
+    if (scratch_label != NULL) return false;
+#endif
+
+    const esp_partition_t *partition = NULL;
+
+    if (scratch_label != NULL)
+    {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, scratch_label);
+
+        if (partition == NULL) return false;
+    }
+
+    // Internal RAM: the ISR reads them with the disabled cache (no PSRAM)
+    bench_buttons = heap_caps_calloc(config->buttons_quantity, sizeof(bench_button), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    bench_ctx = heap_caps_calloc(config->buttons_quantity, sizeof(button_ctx), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    if (bench_buttons == NULL || bench_ctx == NULL)
+    {
+        heap_caps_free(bench_buttons);
+        heap_caps_free(bench_ctx);
+
+        return false;
+    }
+
+    bench_config = config;
+
+    button_ctx template_button = bench_template_button(config->PIN);
+
+    for (unsigned int i = 0; i < config->buttons_quantity; i++)
+    {
+        bench_ctx[i] = template_button;
+    }
+
+    // Long presses for the long-time / infinite APIs, short ones for the others
+    bool long_api = (config->api == BUT_BENCH_FLAG_LONGTIME || config->api == BUT_BENCH_CALLBACK_LONGTIME ||
+                     config->api == BUT_BENCH_CALLBACK_INFINITE || config->api == BUT_BENCH_FLAG_INFINITE);
+    uint32_t press_ms = long_api ? BENCH_LONG_HOLD_MIN_MS : BENCH_STALL_SHORT_PRESS_MS;
+
+    stall_press_passes = press_ms * 1000 / period_us;
+    stall_cycle_passes = (press_ms + BENCH_STALL_IDLE_MS) * 1000 / period_us;
+
+    stall_passes = 0;
+    stall_pass_max_cycles = 0;
+    stall_gap_max_cycles = 0;
+
+    stall_flash_stop = false;
+    stall_flash_done = false;
+    stall_flash_ops = 0;
+
+    button_profiler_reset();
+    button_input_source_set(bench_stall_input);
+
+    // Timer ISR passes (IRAM-safe with CONFIG_GPTIMER_ISR_IRAM_SAFE)
+    gptimer_handle_t timer = NULL;
+
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+
+    gptimer_event_callbacks_t timer_callbacks = { .on_alarm = bench_stall_isr };
+
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = period_us,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+
+    bool timer_ready = (gptimer_new_timer(&timer_config, &timer) == ESP_OK);
+
+    if (timer_ready &&
+        (gptimer_register_event_callbacks(timer, &timer_callbacks, NULL) != ESP_OK ||
+         gptimer_set_alarm_action(timer, &alarm) != ESP_OK ||
+         gptimer_enable(timer) != ESP_OK))
+    {
+        gptimer_del_timer(timer);
+        timer_ready = false;
+    }
+
+    if (timer_ready)
+    {
+        gptimer_start(timer);
+
+        if (partition != NULL)
+            xTaskCreatePinnedToCore(bench_flash_load, "bench_flash", 3072, (void *)partition, 5, NULL, tskNO_AFFINITY);
+        else
+            stall_flash_done = true;
+
+        vTaskDelay(pdMS_TO_TICKS(config->duration_ms));
+
+        stall_flash_stop = true;
+
+        while (!stall_flash_done) vTaskDelay(1);
+
+        gptimer_stop(timer);
+        gptimer_disable(timer);
+        gptimer_del_timer(timer);
+    }
+
+    button_input_source_set(NULL);
+
+    if (timer_ready)
+    {
+        // Profiler rows are in the order of the benchmarked APIs
+        button_profiler_api api = (button_profiler_api)config->api;
+        button_profiler_counter total = button_profiler_get(api, BUT_PROF_SECTION_TOTAL);
+        uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+
+        printf("{\"bench\":\"button_control_flash_stall\",\"api\":\"%s\",\"buttons\":%u,\"period_us\":%u,"
+               "\"iram\":%s,\"flash_load\":%s,\"flash_ops\":%u,\"passes\":%u,"
+               "\"api_calls\":%u,\"api_avg_cycles\":%u,\"api_max_cycles\":%u,"
+               "\"sample_max_cycles\":%u,\"debounce_max_cycles\":%u,\"timers_max_cycles\":%u,"
+               "\"state_machine_max_cycles\":%u,\"callback_max_cycles\":%u,"
+               "\"pass_max_cycles\":%u,\"pass_gap_max_us\":%u}\n",
+               bench_api_names[config->api], config->buttons_quantity, (unsigned)period_us,
+               BUTTON_CONTROL_IRAM ? "true" : "false", (partition != NULL) ? "true" : "false",
+               (unsigned)stall_flash_ops, (unsigned)stall_passes,
+               (unsigned)total.calls, (unsigned)button_profiler_average(&total), (unsigned)total.max_cycles,
+               (unsigned)button_profiler_get(api, BUT_PROF_SECTION_SAMPLE).max_cycles,
+               (unsigned)button_profiler_get(api, BUT_PROF_SECTION_DEBOUNCE).max_cycles,
+               (unsigned)button_profiler_get(api, BUT_PROF_SECTION_TIMERS).max_cycles,
+               (unsigned)button_profiler_get(api, BUT_PROF_SECTION_STATE_MACHINE).max_cycles,
+               (unsigned)button_profiler_get(api, BUT_PROF_SECTION_CALLBACK).max_cycles,
+               (unsigned)stall_pass_max_cycles, (unsigned)(stall_gap_max_cycles / ticks_per_us));
+    }
+
+    heap_caps_free(bench_buttons);
+    heap_caps_free(bench_ctx);
+
+    bench_buttons = NULL;
+    bench_ctx = NULL;
+
+    return timer_ready;
+}
+
+#endif // BUTTON_CONTROL_PROFILER
+
+
+#if BUTTON_CONTROL_EVENTS
+
+bool button_bench_replay(const button_bench_config *config, uint32_t tick_us, uint32_t trace_capacity)
+{
+    // Error handler
+    if (!bench_config_valid(config) || config->buttons_quantity > BENCH_REPLAY_MAX_BUTTONS) return false;
+    if (tick_us == 0 || trace_capacity < BUT_TRACE_RECORD_MAX_SIZE) return false;
+
+    bench_buttons = calloc(config->buttons_quantity, sizeof(bench_button));
+    bench_ctx = calloc(config->buttons_quantity, sizeof(button_ctx));
+    replay_events = calloc(BENCH_REPLAY_EVENTS_MAX, sizeof(button_event));
+
+    uint8_t *ring = malloc(trace_capacity);
+    uint8_t *trace = malloc(trace_capacity + BUT_TRACE_HEADER_SIZE);
+
+    bool ready = (bench_buttons && bench_ctx && replay_events && ring && trace) &&
+                 button_event_listener_add(bench_replay_listener, NULL);
+
+    if (!ready)
+    {
+        free(bench_buttons);
+        free(bench_ctx);
+        free(replay_events);
+        free(ring);
+        free(trace);
+
+        bench_buttons = NULL;
+        bench_ctx = NULL;
+        replay_events = NULL;
+
+        return false;
+    }
+
+    bench_config = config;
+
+    button_ctx template_button = bench_template_button(config->PIN);
+
+    int64_t generation_end_us = (int64_t)config->duration_ms * 1000;
+    int64_t end_us = generation_end_us + BENCH_TAIL_MS * 1000;
+
+    // Recording: contact models on the virtual clock, one bank sample per tick
+    replay_clock_us = 0;
+    replay_events_quantity = 0;
+    replay_recording = true;
+
+    bench_bank_buttons_reset(&template_button);
+
+    for (unsigned int i = 0; i < config->buttons_quantity; i++) bench_sim_reset(&bench_buttons[i], config, i, 0);
+
+    button_trace_recorder recorder;
+    button_trace_recorder_init(&recorder, ring, trace_capacity);
+
+    button_time_source_set(bench_replay_clock);
+    button_bank_source_set(bench_bank_source);
+
+    for (; replay_clock_us < end_us; replay_clock_us += tick_us)
+    {
+        for (unsigned int i = 0; i < config->buttons_quantity; i++)
+        {
+            bench_schedule(&bench_buttons[i], replay_clock_us, generation_end_us);
+            bench_buttons[i].raw_level = !bench_contact_level(&bench_buttons[i], i, replay_clock_us);
+        }
+
+        button_trace_record(&recorder, button_bank_sample());
+
+        for (bench_current = 0; bench_current < config->buttons_quantity; bench_current++)
+        {
+            bench_api_call(&bench_ctx[bench_current], &bench_buttons[bench_current]);
+        }
+    }
+
+    button_bank_source_set(NULL);
+    button_time_source_set(NULL);
+
+    uint32_t trace_size = button_trace_export(&recorder, trace, trace_capacity + BUT_TRACE_HEADER_SIZE);
+
+    // Replay of the exported trace on its virtual clock, same tick
+    replay_recording = false;
+    replay_events_position = 0;
+    replay_mismatches = 0;
+
+    bench_bank_buttons_reset(&template_button);
+
+    button_trace_replay replay;
+    bool parsed = button_trace_replay_init(&replay, trace, trace_size);
+
+    int64_t replay_start_us = esp_timer_get_time();
+
+    if (parsed)
+    {
+        button_trace_replay_start_virtual(&replay);
+
+        do
+        {
+            button_bank_sample();
+
+            for (bench_current = 0; bench_current < config->buttons_quantity; bench_current++)
+            {
+                bench_api_call(&bench_ctx[bench_current], &bench_buttons[bench_current]);
+            }
+
+            button_trace_replay_advance(&replay, tick_us);
+        }
+        while (replay.now_us < end_us);
+
+        button_trace_replay_stop(&replay);
+    }
+
+    int64_t replay_real_us = esp_timer_get_time() - replay_start_us;
+
+    button_event_listener_remove(bench_replay_listener, NULL);
+
+    // Missing replay events are mismatches too
+    if (replay_events_position < replay_events_quantity) replay_mismatches += replay_events_quantity - replay_events_position;
+
+    bool identical = parsed && recorder.dropped_records == 0 && replay_events_quantity < BENCH_REPLAY_EVENTS_MAX &&
+                     replay_mismatches == 0;
+
+    printf("{\"bench\":\"button_control_replay\",\"api\":\"%s\",\"model\":\"%s\",\"buttons\":%u,"
+           "\"tick_us\":%u,\"simulated_ms\":%u,\"trace_bytes\":%u,\"records\":%u,\"dropped_records\":%u,"
+           "\"events\":%u,\"replay_events\":%u,\"mismatches\":%u,\"identical\":%s,\"replay_real_us\":%lld}\n",
+           bench_api_names[config->api], bench_model_names[config->bounce_model], config->buttons_quantity,
+           (unsigned)tick_us, (unsigned)(end_us / 1000), (unsigned)trace_size, (unsigned)recorder.records,
+           (unsigned)recorder.dropped_records, (unsigned)replay_events_quantity, (unsigned)replay_events_position,
+           (unsigned)replay_mismatches, identical ? "true" : "false", (long long)replay_real_us);
+
+    free(bench_buttons);
+    free(bench_ctx);
+    free(replay_events);
+    free(ring);
+    free(trace);
+
+    bench_buttons = NULL;
+    bench_ctx = NULL;
+    replay_events = NULL;
+
+    return identical;
+}
+
+#endif // BUTTON_CONTROL_EVENTS
+
+
+#if BUTTON_CONTROL_ENCODER
+
+bool button_bench_encoder(gpio_num_t PIN_A, gpio_num_t PIN_B, uint32_t tick_us, uint32_t phase_error_percent,
+                          uint32_t tick_jitter_percent)
+{
+    static const uint32_t rate_percents[] = { 10, 25, 50, 60, 70, 80, 90, 95, 100, 110, 125, 150 };
+    const uint32_t rates_quantity = sizeof(rate_percents) / sizeof(rate_percents[0]);
+
+    // Error handler
+    if (tick_us < 10 || phase_error_percent > 90 || tick_jitter_percent > 90) return false;
+
+    uint32_t tick_rate = 1000000 / tick_us;
+    uint32_t max_rate = 0;
+    uint32_t rng = 0x12345678u;
+
+    encoder_b_shift = phase_error_percent * 10000;
+
+    button_bank_source_set(bench_encoder_bank_source);
+
+    for (uint32_t r = 0; r < rates_quantity; r++)
+    {
+        encoder_rate = tick_rate * rate_percents[r] / 100;
+        encoder_time_us = 0;
+
+        // Rest position at the time 0 (levels come from the simulated bank)
+        bench_encoder.PIN_A = PIN_A;
+        bench_encoder.PIN_B = PIN_B;
+
+        if (button_encoder_initialization(&bench_encoder, PIN_A, PIN_B, GPIO_PULLUP_ONLY, 4) != ESP_OK)
+        {
+            button_bank_source_set(NULL);
+            return false;
+        }
+
+        uint64_t sample_cycles = 0;
+
+        for (uint32_t tick = 0; tick < BENCH_ENCODER_TICKS; tick++)
+        {
+            // Loop period with the jitter
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+
+            int32_t jitter_us = (int32_t)(tick_us * tick_jitter_percent / 100);
+            int32_t period_us = (int32_t)tick_us + (jitter_us ? (int32_t)(rng % (2 * jitter_us + 1)) - jitter_us : 0);
+
+            encoder_time_us += period_us;
+
+            uint32_t cycles_start = (uint32_t)esp_cpu_get_cycle_count();
+
+            button_bank_sample();
+
+            sample_cycles += (uint32_t)esp_cpu_get_cycle_count() - cycles_start;
+        }
+
+        // Ground truth against the decoded steps
+        int64_t truth_steps = encoder_time_us * encoder_rate / 1000000;
+        int64_t decoded_steps = (int64_t)bench_encoder.position * 4 + bench_encoder.sub_steps;
+        int64_t lost_steps = truth_steps - decoded_steps;
+
+        if (lost_steps < 0) lost_steps = -lost_steps;
+
+        bool tracked = (lost_steps == 0 && bench_encoder.errors == 0);
+
+        if (tracked && encoder_rate > max_rate) max_rate = encoder_rate;
+
+        printf("{\"bench\":\"button_control_encoder\",\"tick_us\":%u,\"phase_error_percent\":%u,"
+               "\"tick_jitter_percent\":%u,\"rate_steps_per_s\":%u,\"steps\":%lld,\"decoded\":%lld,"
+               "\"errors\":%u,\"lost_steps\":%lld,\"tracked\":%s,\"ns_per_sample\":%u}\n",
+               (unsigned)tick_us, (unsigned)phase_error_percent, (unsigned)tick_jitter_percent,
+               (unsigned)encoder_rate, (long long)truth_steps, (long long)decoded_steps,
+               (unsigned)bench_encoder.errors, (long long)lost_steps, tracked ? "true" : "false",
+               (unsigned)(sample_cycles * 1000 / esp_rom_get_cpu_ticks_per_us() / BENCH_ENCODER_TICKS));
+
+        button_encoder_remove(&bench_encoder);
+    }
+
+    button_bank_source_set(NULL);
+
+    printf("{\"bench\":\"button_control_encoder_max\",\"tick_us\":%u,\"phase_error_percent\":%u,"
+           "\"tick_jitter_percent\":%u,\"max_rate_steps_per_s\":%u,\"max_rate_detents_per_s\":%u}\n",
+           (unsigned)tick_us, (unsigned)phase_error_percent, (unsigned)tick_jitter_percent,
+           (unsigned)max_rate, (unsigned)(max_rate / 4));
+
+    return true;
+}
+
+#endif // BUTTON_CONTROL_ENCODER
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Handoff stress consumer state
+static button_event_queue handoff_queue;
+static volatile bool handoff_stop;
+static volatile bool handoff_done;
+static uint32_t handoff_load_us;
+
+
+// Loaded consumer: every event costs handoff_load_us of the busy work
+static void bench_handoff_consumer(void *parameter)
+{
+    (void)parameter;
+
+    button_event event;
+
+    // Start after the queue init
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    while (!handoff_stop)
+    {
+        if (button_event_queue_receive(&handoff_queue, &event, pdMS_TO_TICKS(10)))
+        {
+            esp_rom_delay_us(handoff_load_us);
+        }
+    }
+
+    // Drain the rest
+    while (button_event_queue_receive(&handoff_queue, &event, 0));
+
+    handoff_done = true;
+    vTaskDelete(NULL);
+}
+
+
+bool button_bench_handoff(const button_bench_config *config, uint32_t consumer_load_us, uint32_t queue_capacity,
+                          BaseType_t consumer_core)
+{
+    button_event *events = calloc(queue_capacity, sizeof(button_event));
+
+    if (events == NULL) return false;
+
+    handoff_stop = false;
+    handoff_done = false;
+    handoff_load_us = consumer_load_us;
+
+    TaskHandle_t consumer;
+
+    if (xTaskCreatePinnedToCore(bench_handoff_consumer, "bench_consumer", 3072, NULL, 5, &consumer,
+                                consumer_core) != pdPASS)
+    {
+        free(events);
+        return false;
+    }
+
+    if (!button_event_queue_init(&handoff_queue, events, queue_capacity, consumer) ||
+        !button_event_queue_attach(&handoff_queue))
+    {
+        handoff_stop = true;
+        xTaskNotifyGive(consumer);
+
+        while (!handoff_done) vTaskDelay(1);
+
+        free(events);
+        return false;
+    }
+
+    xTaskNotifyGive(consumer);
+
+    // Producer: the benchmark loop plays the sampler
+    button_bench_result result;
+    bool run = button_bench_run(config, &result);
+
+    button_event_queue_detach(&handoff_queue);
+
+    handoff_stop = true;
+
+    while (!handoff_done) vTaskDelay(1);
+
+    if (run)
+    {
+        uint32_t pushed = (uint32_t)atomic_load(&handoff_queue.pushed);
+        uint32_t dropped = (uint32_t)atomic_load(&handoff_queue.dropped);
+        uint32_t received = handoff_queue.received;
+
+        printf("{\"bench\":\"button_control_handoff\",\"api\":\"%s\",\"buttons\":%u,"
+               "\"consumer_load_us\":%u,\"queue_capacity\":%u,\"consumer_core\":%d,"
+               "\"pushed\":%u,\"dropped\":%u,\"received\":%u,\"loss_rate\":%.4f,"
+               "\"latency_avg_us\":%lld,\"latency_max_us\":%lld}\n",
+               bench_api_names[config->api], config->buttons_quantity,
+               (unsigned)consumer_load_us, (unsigned)queue_capacity, (int)consumer_core,
+               (unsigned)pushed, (unsigned)dropped, (unsigned)received,
+               (pushed + dropped) ? (float)dropped / (pushed + dropped) : 0.0f,
+               received ? (long long)(handoff_queue.latency_total_us / received) : 0LL,
+               (long long)handoff_queue.latency_max_us);
+    }
+
+    free(events);
+
+    return run;
+}
+
+#endif // BUTTON_CONTROL_EVENTS
+
+// =========================================================================================== API REALIZATION
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+// Build with BUTTON_CONTROL_SIM_INPUT 1 (and BUTTON_CONTROL_PROFILER 1 for the per-section split).
+// The run is blocking: call it from a task with the task watchdog disabled for it.
+
+#include <my_libs/button_control/button_control_bench.h>
+
+void app_main()
+{
+    static const unsigned int buttons[] = { 1, 8, 64, 256, 1024 };
+
+    for (int api = 0; api < BUT_BENCH_API_QUANTITY; api++)
+    {
+        for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+        {
+            for (int n = 0; n < 5; n++)
+            {
+                button_bench_config config = button_bench_config_default(GPIO_NUM_4, api);
+                button_bench_result result;
+
+                config.bounce_model = model;
+                config.buttons_quantity = buttons[n];
+
+                if (button_bench_run(&config, &result)) button_bench_print_result(&config, &result);
+            }
+        }
+    }
+
+    // Light sleep simulation: wakeups per hour of the tickless loop for the same press schedule
+    button_bench_config config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_FLAG_ONETIME);
+    button_bench_result result;
+
+    config.buttons_quantity = 8;
+    config.idle_mean_ms = 60000;    // One press per minute per button
+    config.duration_ms = 600000;
+    config.tickless = true;
+
+    if (button_bench_run(&config, &result)) button_bench_print_result(&config, &result);
+
+    // Startup cost against the buttons quantity
+    static const gpio_num_t free_pins[] = { GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_18, GPIO_NUM_19 };
+
+    for (unsigned int n = 1; n <= 64; n *= 2)
+    {
+        button_bench_startup(free_pins, 4, n);
+    }
+
+    // Sampler -> consumer handoff under the loaded consumer (run it from the core 0 task)
+    config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_CALLBACK_ONETIME);
+    config.buttons_quantity = 64;
+    config.idle_mean_ms = 200;
+
+    static const uint32_t loads_us[] = { 0, 1000, 5000, 20000 };
+
+    for (int load = 0; load < 4; load++)
+    {
+        button_bench_handoff(&config, loads_us[load], 16, 1);
+    }
+}
+
+*/
+
+
+/*
+
+// Worst case under the flash writes: build with BUTTON_CONTROL_PROFILER 1 and BUTTON_CONTROL_IRAM 1,
+// CONFIG_GPTIMER_ISR_IRAM_SAFE=y, async_await in IRAM and a scratch data partition in partitions.csv:
+//
+//   scratch,  data, 0x40,  ,  0x1000
+//
+// Compare the api_max_cycles / pass_gap_max_us of the runs without and with the flash load: with the IRAM
+// poll path they stay the same, a flash-resident path would crash on the first pass with the disabled cache.
+
+void app_main()
+{
+    button_bench_config config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_FLAG_ONETIME);
+
+    config.buttons_quantity = 16;
+    config.duration_ms = 10000;
+
+    button_bench_flash_stall(&config, NULL, 1000);          // Baseline
+    button_bench_flash_stall(&config, "scratch", 1000);     // Flash erase / write in parallel
+}
+
+*/
+
+
+/*
+
+// Replay determinism: record a run on the virtual clock, replay the exported trace faster than the
+// real time and compare the events (BUTTON_CONTROL_EVENTS 1, button_control_trace in the build)
+
+void app_main()
+{
+    button_bench_config config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_FLAG_LONGTIME);
+
+    config.buttons_quantity = 8;
+    config.duration_ms = 60000;
+
+    button_bench_replay(&config, 1000, 32768);
+}
+
+*/
+
+
+/*
+
+// C API against the C++ templates of button_control.hpp on the same presses (C++ component with
+// button_control_bench_templates.cpp in the sources): ns per poll of 8 buttons and the events of both sides
+
+void app_main()
+{
+    for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+    {
+        button_bench_config config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_FLAG_ONETIME);
+
+        config.bounce_model = model;
+
+        button_bench_templates(&config);
+    }
+}
+
+*/
+
+
+/*
+
+// Contact health in the light sleep loop (BUTTON_CONTROL_HEALTH 1): the settled presses of the tickless run
+// must be the same as of the run polled every pass, the chatter pulses are rejected in both
+
+void app_main()
+{
+    for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+    {
+        button_bench_config config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_FLAG_ONETIME);
+
+        config.buttons_quantity = 8;
+        config.bounce_model = model;
+
+        if (!button_bench_health_tickless(&config)) printf("Health statistics differ in the tickless loop\n");
+    }
+}
+
+*/
+
+
+/*
+
+// Encoder: max step rate without the lost steps for the 1 ms poll task (BUTTON_CONTROL_ENCODER 1).
+// Ideal 90 degrees phase tracks up to 1 step per sample, the phase error / loop jitter lower the limit.
+
+void app_main()
+{
+    button_bench_encoder(GPIO_NUM_18, GPIO_NUM_19, 1000, 0, 0);      // Ideal encoder, exact period
+    button_bench_encoder(GPIO_NUM_18, GPIO_NUM_19, 1000, 20, 10);    // Real encoder, vTaskDelay jitter
+}
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
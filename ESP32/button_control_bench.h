@@ -0,0 +1,277 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - microbenchmark with bounce models (Header File, C version)
+
+// Author: dimakomplekt
+
+// Description: Drives N simulated buttons (1..1024) through the button_control APIs with parametric
+// contact models: exponential chatter, EMI spikes, slow RC edges and human press / hold distributions.
+// Measures ns per tick, events per second and false / missed event rates per API, and the worst-case
+// cycles of the poll path under the flash writes (BUTTON_CONTROL_PROFILER, BUTTON_CONTROL_IRAM) and the max
+// trackable step rate of the quadrature encoder decoding (BUTTON_CONTROL_ENCODER), checks that the
+// virtual clock trace replay repeats the recorded events (BUTTON_CONTROL_EVENTS) and compares the C API
+// with the C++ templates of button_control.hpp on the same inputs (button_control_bench_templates.cpp).
+// Results are printed as one JSON line per run, so they can be collected and compared by scripts.
+
+// Requires BUTTON_CONTROL_SIM_INPUT 1 (simulated levels are passed through the input source hook).
+// Runs on the target (app_main, examples at the end of the C-file) and on the host: tools/host builds the
+// same sources against the host port and runs the suites by tools/host/button_host_bench.
+
+// Instruction - at the end of the C-file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_BENCH_H
+#define BUTTON_CONTROL_BENCH_H
+
+// =========================================================================================== IMPORT
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "button_control.h"
+
+#if BUTTON_CONTROL_EVENTS
+    #include "freertos/FreeRTOS.h"          // For BaseType_t of the handoff consumer core
+#endif
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#define BUT_BENCH_MAX_BUTTONS 1024              // Maximum simulated buttons quantity
+#define BUT_BENCH_TEMPLATES_BUTTONS 8           // Templates bench: buttons of the compile-time bank (pins 0..7)
+
+// =========================================================================================== DEFINES
+
+
+// =========================================================================================== EXT ENUMS
+
+// Contact bounce models
+typedef enum {
+
+    BUT_BOUNCE_CLEAN,                   // Ideal contact, edges without bounce
+    BUT_BOUNCE_EXPONENTIAL_CHATTER,     // Random chatter after every edge, decays by exp(-t / bounce_us)
+    BUT_BOUNCE_EMI_SPIKES,              // Clean edges + short random inverted spikes at any time
+    BUT_BOUNCE_SLOW_RC,                 // RC edge (tau = bounce_us), noisy while the level is near the threshold
+
+    BUT_BOUNCE_QUANTITY
+
+} button_bounce_model;
+
+// Benchmarked APIs
+typedef enum {
+
+    BUT_BENCH_FLAG_ONETIME,             // flag_control_by_but_onetime_press
+    BUT_BENCH_FLAG_MULTIPLE,            // flag_control_by_but_multiple_press (clicks_per_burst presses)
+    BUT_BENCH_FLAG_LONGTIME,            // flag_control_by_but_longtime_press
+    BUT_BENCH_FLAG_INFINITE,            // flag_control_by_but_infinite_press
+
+    BUT_BENCH_CALLBACK_ONETIME,         // callback_control_by_but_onetime_press (1 repeat)
+    BUT_BENCH_CALLBACK_MULTIPLE,        // callback_control_by_but_multiple_press (1 repeat)
+    BUT_BENCH_CALLBACK_LONGTIME,        // callback_control_by_but_longtime_press (1 repeat)
+    BUT_BENCH_CALLBACK_INFINITE,        // callback_control_by_but_infinite_press (1 repeat)
+
+    BUT_BENCH_API_QUANTITY
+
+} button_bench_api;
+
+// =========================================================================================== EXT ENUMS
+
+
+// =========================================================================================== EXT STRUCTS
+
+// Benchmark run configuration
+typedef struct
+{
+    gpio_num_t PIN;                     // Free pin for the template button init (simulated levels replace its reads)
+
+    button_bench_api api;               // Benchmarked API
+    unsigned int buttons_quantity;      // Simulated buttons quantity (1..BUT_BENCH_MAX_BUTTONS)
+
+    button_bounce_model bounce_model;   // Contact model
+    uint32_t bounce_us;                 // Chatter decay / RC time constant
+    uint32_t spike_width_us;            // EMI spike width
+    uint32_t spikes_per_s;              // EMI spikes rate per button
+
+    uint32_t press_min_ms;              // Short press duration range (human press distribution)
+    uint32_t press_max_ms;
+    uint32_t long_hold_percent;         // Share of the presses held longer than the long-time press (+0.5 .. 2 s)
+    uint32_t idle_mean_ms;              // Mean of the exponential idle gap between the press bursts
+    uint8_t clicks_per_burst;           // Presses in one burst (multiple press APIs)
+
+    bool tickless;                      // Call the APIs only on the pin edges and button_next_wakeup_us deadlines
+                                        // (light sleep simulation, requires BUTTON_CONTROL_WAKEUP 1)
+
+    uint32_t duration_ms;               // Presses generation time (4 s of quiet tail are added for the events settle)
+    uint32_t seed;                      // Random seed
+
+} button_bench_config;
+
+// Benchmark run result
+typedef struct
+{
+    uint64_t ticks;                     // Passes over all the buttons
+    uint64_t elapsed_us;                // Whole run time
+    uint64_t api_us;                    // Time spent inside the API calls
+
+    uint32_t ns_per_tick;               // API time per pass over all the buttons
+    uint32_t ns_per_button;             // API time per one button call
+
+    uint32_t expected_events;           // Ground truth events by the press schedule
+    uint32_t detected_events;           // Events, detected by the API
+    uint32_t false_events;              // Detected over the expected (sum by buttons)
+    uint32_t missed_events;             // Expected, but not detected (sum by buttons)
+
+    uint32_t events_per_s;              // Detected events per second
+
+    uint64_t awake_ticks;               // Tickless: passes with the API calls
+    uint32_t wakeups;                   // Tickless: sleep -> awake transitions
+    uint32_t wakeups_per_hour;          // Tickless: wakeups extrapolated to one hour
+
+#if BUTTON_CONTROL_HEALTH
+    uint32_t health_presses;            // Contact health: settled presses (sum by buttons)
+    uint32_t chatter_rejected;          // Contact health: rejected pulses (sum by buttons)
+    uint32_t bounce_mean_us;            // Contact health: mean bounce of all transitions
+    uint32_t bounce_max_us;             // Contact health: longest bounce
+#endif
+
+} button_bench_result;
+
+// =========================================================================================== EXT STRUCTS
+
+
+// =========================================================================================== API
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Function: button_bench_config_default
+// Purpose: Return the config with the realistic defaults (64 buttons, chatter 300 us, 60..250 ms presses,
+// 10% long holds, 700 ms mean idle gap, 20 s run).
+// Call as: button_bench_config config = button_bench_config_default(GPIO_NUM_4, BUT_BENCH_FLAG_ONETIME);
+button_bench_config button_bench_config_default(gpio_num_t PIN, button_bench_api api);
+
+
+// Function: button_bench_run
+// Purpose: Run the benchmark by the config (blocking, duration_ms + 4 s).
+// Returns false if the config is wrong or there is no memory for the buttons.
+// Call as: button_bench_run(&config, &result);
+bool button_bench_run(const button_bench_config *config, button_bench_result *result);
+
+
+// Function: button_bench_print_result
+// Purpose: Print the config and the result as one JSON line by printf.
+// Call as: button_bench_print_result(&config, &result);
+void button_bench_print_result(const button_bench_config *config, const button_bench_result *result);
+
+
+// Function: button_bench_startup
+// Purpose: Measure the startup cost of the buttons_quantity buttons: button_initialization (by value,
+// separate pin calls) against button_initialization_bulk (in place, pin masks). Buttons are spread
+// over the given free pins (pins are reconfigured several times if there are less pins than buttons).
+// Prints one JSON line. Returns false if there is no memory for the buttons.
+// Call as: button_bench_startup(free_pins, 8, 64);
+bool button_bench_startup(const gpio_num_t *pins, size_t pins_quantity, unsigned int buttons_quantity);
+
+
+// Function: button_bench_templates
+// Purpose: Compare the C API with the C++ templates (button_control.hpp): 8 simulated buttons of the config
+// contact model on the bank bits 0..7 are passed to both sides in the same pass - flag onetime / longtime
+// press APIs of the C ctxs (api: BUT_BENCH_FLAG_ONETIME or BUT_BENCH_FLAG_LONGTIME) and the same gesture of
+// the ButtonBank<Button<GPIO_NUM_0..7>>. Each side is timed separately from the same snapshot (C: bank sample
+// + 8 API calls, C++: esp_timer_get_time + bank update). Prints one JSON line with the ns per pass and the
+// expected / detected / false / missed events of both sides. Requires button_control_bench_templates.cpp
+// in the build. Returns false on the wrong config / no memory.
+// Call as: button_bench_templates(&config);
+bool button_bench_templates(const button_bench_config *config);
+
+
+// C++ side of the button_bench_templates (button_control_bench_templates.cpp): reset the bank / update it
+// by the snapshot, Onetime and LongPress gestures are counted per button index
+void button_bench_templates_reset(void);
+void button_bench_templates_update(const button_bank_snapshot *bank, int64_t now_us, uint32_t *onetime,
+                                   uint32_t *long_press);
+
+
+#if BUTTON_CONTROL_HEALTH && BUTTON_CONTROL_WAKEUP
+
+// Function: button_bench_health_tickless
+// Purpose: Check the contact health statistics in the light sleep loop: the config is run twice with the
+// same seed - the APIs called every pass and only on the pin edges / button_next_wakeup_us deadlines.
+// Prints one JSON line with the settled presses, rejected chatter and mean bounce of both runs.
+// Returns true if both runs settled the same presses (false also on the wrong config / no memory).
+// Call as: button_bench_health_tickless(&config);
+bool button_bench_health_tickless(const button_bench_config *config);
+
+#endif // BUTTON_CONTROL_HEALTH && BUTTON_CONTROL_WAKEUP
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Function: button_bench_replay
+// Purpose: Check the deterministic replay: the config run (up to 32 buttons on the simulated bank) is
+// recorded by the trace recorder on the virtual clock with the tick_us loop period, the exported trace is
+// replayed on the virtual clock (button_trace_replay_start_virtual) through fresh button ctxs, and the
+// events of both runs are compared (pin, type, count, hold, time). Prints one JSON line with the trace
+// size, events, mismatches and the real time of the replay. Requires the button_control_trace module.
+// Returns true if the replay is identical (false also on the wrong config / no memory / ring overflow).
+// Call as: button_bench_replay(&config, 1000, 32768);
+bool button_bench_replay(const button_bench_config *config, uint32_t tick_us, uint32_t trace_capacity);
+
+#endif // BUTTON_CONTROL_EVENTS
+#if BUTTON_CONTROL_ENCODER
+
+// Function: button_bench_encoder
+// Purpose: Find the max trackable step rate of the encoder decoding: a simulated quadrature encoder on
+// the PIN_A / PIN_B bits of the simulated bank is turned at 10% .. 150% of the sample rate (1 / tick_us)
+// on the simulated clock and decoded by the button_bank_sample. B edges are delayed by phase_error_percent
+// of the quarter step (real encoders are not exactly 90 degrees), the loop period varies by
+// tick_jitter_percent. Prints one JSON line per rate (steps, decoded, skipped states, lost steps, ns per
+// sample) and the max rate without the lost steps. Returns false on the wrong parameters / no encoder slot.
+// Call as: button_bench_encoder(GPIO_NUM_18, GPIO_NUM_19, 1000, 20, 10);
+bool button_bench_encoder(gpio_num_t PIN_A, gpio_num_t PIN_B, uint32_t tick_us, uint32_t phase_error_percent,
+                          uint32_t tick_jitter_percent);
+
+#endif // BUTTON_CONTROL_ENCODER
+
+
+#if BUTTON_CONTROL_PROFILER
+
+// Function: button_bench_flash_stall
+// Purpose: Measure the worst-case cycles of the poll path: the API of the config is called for all buttons
+// from the gptimer ISR every period_us during duration_ms (staggered simulated presses with bouncing edges),
+// while the flash task erases / writes one sector of the scratch data partition again and again
+// (scratch_label - partition label, NULL - no flash load). Prints one JSON line with the profiler max / avg
+// cycles of the API and the max of its sections, the longest ISR pass and the longest gap between passes
+// (a stalled pass shows up as a gap). Flash load requires BUTTON_CONTROL_IRAM 1, CONFIG_GPTIMER_ISR_IRAM_SAFE
+// and the IRAM-resident async_await lib. Returns false on the wrong config / no memory / no partition / timer error.
+// Call as: button_bench_flash_stall(&config, "scratch", 1000);
+bool button_bench_flash_stall(const button_bench_config *config, const char *scratch_label, uint32_t period_us);
+
+#endif // BUTTON_CONTROL_PROFILER
+
+
+#if BUTTON_CONTROL_EVENTS
+
+// Function: button_bench_handoff
+// Purpose: Stress the sampler -> consumer event queue: the benchmark run (calling task) is the producer,
+// the consumer task on the consumer core takes the events and spends consumer_load_us of the busy work
+// on each of them. Prints one JSON line with the pushed / dropped / received events and the handoff
+// latency (avg / max). Requires the button_control_task module. Returns false on the wrong config / no memory.
+// Call as: button_bench_handoff(&config, 2000, 16, 1);
+bool button_bench_handoff(const button_bench_config *config, uint32_t consumer_load_us, uint32_t queue_capacity,
+                          BaseType_t consumer_core);
+
+#endif // BUTTON_CONTROL_EVENTS
+
+#ifdef __cplusplus
+}
+#endif
+
+// =========================================================================================== API
+
+
+#endif // BUTTON_CONTROL_BENCH_H
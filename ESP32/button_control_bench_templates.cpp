@@ -0,0 +1,70 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - microbenchmark, C++ templates side (C++ File)
+
+// Author: dimakomplekt
+
+// Description: ButtonBank of the compile-time buttons for the button_bench_templates (C API against the
+// templates on the same simulated inputs). Only the bank update is here, the run is in the C-file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include "button_control_bench.h"
+#include "button_control.hpp"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== VARIABLES
+
+namespace {
+
+using namespace button_control;
+
+// C API timings: 3 ms debounce, 1 s multipress pause, BUTTON_LONG_PRESS_S long-time press
+using BenchTiming = Timing<3, 1000, BUTTON_LONG_PRESS_S * 1000>;
+
+// Pins 0..7: the simulated bank bits of the C side buttons
+using B0 = Button<GPIO_NUM_0, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B1 = Button<GPIO_NUM_1, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B2 = Button<GPIO_NUM_2, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B3 = Button<GPIO_NUM_3, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B4 = Button<GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B5 = Button<GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B6 = Button<GPIO_NUM_6, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+using B7 = Button<GPIO_NUM_7, GPIO_PULLUP_ONLY, NO_FIX, BenchTiming>;
+
+using BenchBank = ButtonBank<B0, B1, B2, B3, B4, B5, B6, B7>;
+
+static_assert(BenchBank::size == BUT_BENCH_TEMPLATES_BUTTONS, "Templates bench bank size");
+
+BenchBank bench_bank;
+
+} // namespace
+
+// =========================================================================================== VARIABLES
+
+
+// =========================================================================================== API REALIZATION
+
+extern "C" void button_bench_templates_reset(void)
+{
+    bench_bank = BenchBank();
+}
+
+
+extern "C" void button_bench_templates_update(const button_bank_snapshot *bank, int64_t now_us, uint32_t *onetime,
+                                              uint32_t *long_press)
+{
+    bench_bank.update(*bank, now_us, [&](std::size_t index, GestureEvent event)
+    {
+        if (event.gesture == Gesture::Onetime) onetime[index] += 1;
+        else if (event.gesture == Gesture::LongPress) long_press[index] += 1;
+    });
+}
+
+// =========================================================================================== API REALIZATION
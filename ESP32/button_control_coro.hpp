@@ -0,0 +1,448 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - C++20 coroutine gestures (Header File, C++ version)
+
+// Author: dimakomplekt
+
+// Description: Awaitable button gestures for the linear UI flows:
+//
+//   co_await menu.pressed();
+//   co_await menu.long_press(3s);
+//   co_await ok.clicks(2);
+//
+// Awaiting coroutines are resumed by the button events (BUTTON_CONTROL_EVENTS), so nothing is
+// re-checked while the buttons are idle. Coroutine frames and waiters live in the static storage
+// (BUTTON_CORO_FRAMES x BUTTON_CORO_FRAME_SIZE, BUTTON_CORO_WAITERS) - no heap allocation.
+
+// The button APIs are still called by the loop / sampler task, they detect the gestures and report
+// the events: clicks(n) needs the multiple press API with n presses for the button, long_press needs
+// the long-time (or infinite) press API. Coroutines are resumed by the Scheduler::run in the same loop,
+// never from inside the button API call.
+
+// Requires BUTTON_CONTROL_EVENTS 1 and C++20.
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_CORO_HPP
+#define BUTTON_CONTROL_CORO_HPP
+
+// =========================================================================================== IMPORT
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "button_control.h"
+
+#if !BUTTON_CONTROL_EVENTS
+    #error "button_control_coro requires BUTTON_CONTROL_EVENTS 1"
+#endif
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#ifndef BUTTON_CORO_FRAMES
+    #define BUTTON_CORO_FRAMES 4                // Coroutines alive at the same time
+#endif
+
+#ifndef BUTTON_CORO_FRAME_SIZE
+    #define BUTTON_CORO_FRAME_SIZE 512          // Bytes per coroutine frame (locals + awaiters)
+#endif
+
+#ifndef BUTTON_CORO_WAITERS
+    #define BUTTON_CORO_WAITERS 8               // Suspended co_await's at the same time
+#endif
+
+#define BUTTON_CORO_LONG_PRESS_MS (BUTTON_LONG_PRESS_S * 1000)    // Long-time press await of the button APIs
+
+// =========================================================================================== DEFINES
+
+
+namespace button_control {
+
+// =========================================================================================== FRAMES
+
+namespace detail {
+
+// Static storage of the coroutine frames
+struct FramePool
+{
+    alignas(std::max_align_t) static inline unsigned char frames[BUTTON_CORO_FRAMES][BUTTON_CORO_FRAME_SIZE];
+    static inline bool used[BUTTON_CORO_FRAMES];
+
+    static void *allocate(std::size_t size) noexcept
+    {
+        if (size > BUTTON_CORO_FRAME_SIZE) return nullptr;
+
+        for (std::size_t i = 0; i < BUTTON_CORO_FRAMES; i++)
+        {
+            if (used[i]) continue;
+
+            used[i] = true;
+            return frames[i];
+        }
+
+        return nullptr;
+    }
+
+    static void release(void *frame) noexcept
+    {
+        for (std::size_t i = 0; i < BUTTON_CORO_FRAMES; i++)
+        {
+            if (frame == frames[i]) used[i] = false;
+        }
+    }
+};
+
+} // namespace detail
+
+
+// Fire-and-forget coroutine: runs until the first co_await at the call, its frame is released at the end.
+// Converts to false, if there was no free frame (the coroutine is not started then).
+class Task
+{
+public:
+
+    struct promise_type
+    {
+        static void *operator new(std::size_t size) noexcept { return detail::FramePool::allocate(size); }
+        static void operator delete(void *frame) noexcept { detail::FramePool::release(frame); }
+
+        static Task get_return_object_on_allocation_failure() noexcept { return Task(false); }
+
+        Task get_return_object() noexcept { return Task(true); }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { abort(); }
+    };
+
+    explicit operator bool() const { return started; }
+
+private:
+
+    explicit Task(bool started) : started(started) {}
+
+    bool started;
+};
+
+// =========================================================================================== FRAMES
+
+
+// =========================================================================================== SCHEDULER
+
+// Awaited gesture
+enum class Await : uint8_t {
+
+    Pressed,            // BUTTON_EVENT_ONETIME_PRESS
+    Clicks,             // BUTTON_EVENT_MULTIPLE_PRESS with count presses (ONETIME_PRESS for 1)
+    LongPress,          // BUTTON_EVENT_LONG_PRESS / INFINITE_PRESS_START, held for hold_us
+
+};
+
+class Scheduler
+{
+public:
+
+    // Subscribe to the button events (once, before the coroutines start)
+    static bool start()
+    {
+        return button_event_listener_add(listener, nullptr);
+    }
+
+    static void stop()
+    {
+        button_event_listener_remove(listener, nullptr);
+    }
+
+    // Resume the coroutines with the happened gestures. Call in the loop after the button APIs
+    // (the time parameter is for the own clock, default - the button engine time).
+    static void run(int64_t now_us = button_time_us())
+    {
+        for (std::size_t i = 0; i < BUTTON_CORO_WAITERS; i++)
+        {
+            Waiter &waiter = waiters[i];
+
+            if (!waiter.handle) continue;
+
+            // Long press is shorter than the APIs long-time press: no event comes before the duration end,
+            // the hold of the debounced press is checked here (a release moves the baseline to the last press)
+            if (!waiter.ready && waiter.gesture == Await::LongPress && waiter.hold_us < BUTTON_CORO_LONG_PRESS_MS * 1000LL)
+            {
+                const button_ctx *button = waiter.button;
+
+                if (!button_is_held(button)) waiter.press_start_us = button->press_start_us;
+                else if (button->press_start_us != waiter.press_start_us &&
+                         now_us - button->press_start_us >= waiter.hold_us)
+                {
+                    *waiter.result = button_event{};
+
+                    waiter.result->button = button;
+                    waiter.result->PIN = button->PIN;
+                    waiter.result->type = BUTTON_EVENT_LONG_PRESS;
+                    waiter.result->count = 1;
+                    waiter.result->time_us = now_us;
+                    waiter.result->hold_ms = (uint32_t)((now_us - button->press_start_us) / 1000);
+                    waiter.ready = true;
+                }
+            }
+
+            // Long press is longer than the APIs long-time press: the same press still held at the deadline?
+            // (a new debounced press moves press_start_us, the release events clear the deadline)
+            if (!waiter.ready && waiter.deadline_us != 0 && now_us >= waiter.deadline_us)
+            {
+                waiter.deadline_us = 0;
+
+                if (button_is_held(waiter.button) && waiter.button->press_start_us == waiter.press_start_us)
+                {
+                    waiter.result->time_us = now_us;
+                    waiter.result->hold_ms = (uint32_t)((now_us - waiter.press_start_us) / 1000);
+                    waiter.ready = true;
+                }
+            }
+
+            if (!waiter.ready) continue;
+
+            std::coroutine_handle<> handle = waiter.handle;
+
+            waiter = Waiter{};          // Slot is free before the resume (the coroutine may await again)
+            handle.resume();
+        }
+    }
+
+    // Waiter registration by the awaiter (false - no free slot)
+    static bool add(std::coroutine_handle<> handle, const button_ctx *button, Await gesture, uint8_t count,
+                    int64_t hold_us, button_event *result)
+    {
+        for (std::size_t i = 0; i < BUTTON_CORO_WAITERS; i++)
+        {
+            if (waiters[i].handle) continue;
+
+            // Press baseline: the shorter long press counts the presses debounced after the co_await
+            waiters[i] = Waiter{ handle, button, gesture, count, hold_us, 0, button->press_start_us, false, result };
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+
+    struct Waiter
+    {
+        std::coroutine_handle<> handle;
+        const button_ctx *button;
+        Await gesture;
+        uint8_t count;
+        int64_t hold_us;
+
+        int64_t deadline_us;            // Long press check time (0 - no check)
+        int64_t press_start_us;
+
+        bool ready;                     // Resume at the next run
+        button_event *result;           // Event for the await_resume
+    };
+
+    static inline Waiter waiters[BUTTON_CORO_WAITERS];
+
+    // Event matching (inside the button API call - no resumes here)
+    static void listener(const button_event *event, void *)
+    {
+        for (std::size_t i = 0; i < BUTTON_CORO_WAITERS; i++)
+        {
+            Waiter &waiter = waiters[i];
+
+            if (!waiter.handle || waiter.ready || waiter.button != event->button) continue;
+
+            // Release of the checked press: no long press check at the deadline
+            if (event->type == BUTTON_EVENT_ONETIME_PRESS || event->type == BUTTON_EVENT_MULTIPLE_PRESS ||
+                event->type == BUTTON_EVENT_INFINITE_PRESS_END) waiter.deadline_us = 0;
+
+            bool match = false;
+
+            switch (waiter.gesture)
+            {
+                case Await::Pressed:
+                    match = (event->type == BUTTON_EVENT_ONETIME_PRESS);
+                    break;
+
+                case Await::Clicks:
+                    match = (waiter.count == 1) ? (event->type == BUTTON_EVENT_ONETIME_PRESS)
+                                                : (event->type == BUTTON_EVENT_MULTIPLE_PRESS &&
+                                                   event->count == waiter.count);
+                    break;
+
+                case Await::LongPress:
+                    if (event->type != BUTTON_EVENT_LONG_PRESS && event->type != BUTTON_EVENT_INFINITE_PRESS_START)
+                        break;
+
+                    if ((int64_t)event->hold_ms * 1000 >= waiter.hold_us) match = true;
+                    else
+                    {
+                        // Check the hold again at the requested duration
+                        waiter.press_start_us = event->button->press_start_us;
+                        waiter.deadline_us = waiter.press_start_us + waiter.hold_us;
+                        *waiter.result = *event;
+                    }
+                    break;
+            }
+
+            if (!match) continue;
+
+            *waiter.result = *event;
+            waiter.ready = true;
+        }
+    }
+};
+
+// =========================================================================================== SCHEDULER
+
+
+// =========================================================================================== AWAITERS
+
+// co_await result: the event, that resumed the coroutine (event.type == BUTTON_EVENT_QUANTITY - the await
+// was not registered, no free waiter slot)
+class GestureAwaiter
+{
+public:
+
+    GestureAwaiter(const button_ctx *button, Await gesture, uint8_t count, int64_t hold_us)
+        : button(button), gesture(gesture), count(count), hold_us(hold_us)
+    {
+        result.type = BUTTON_EVENT_QUANTITY;
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        // No free slot - continue at once with the empty result
+        return Scheduler::add(handle, button, gesture, count, hold_us, &result);
+    }
+
+    button_event await_resume() const noexcept { return result; }
+
+private:
+
+    const button_ctx *button;
+    Await gesture;
+    uint8_t count;
+    int64_t hold_us;
+
+    button_event result = {};
+};
+
+
+// Awaitable gestures of the C button ctx
+class AwaitButton
+{
+public:
+
+    explicit AwaitButton(button_ctx &button) : button(&button) {}
+
+    // Short press (onetime press event)
+    GestureAwaiter pressed() const
+    {
+        return GestureAwaiter(button, Await::Pressed, 1, 0);
+    }
+
+    // Long press: resumed by the long-time press event of the APIs (after BUTTON_LONG_PRESS_S of the hold).
+    // Longer durations: the same debounced press must be still held at the duration end (button_is_held),
+    // a release / new press before it cancels the check until the next long-time press event.
+    // Shorter durations: resumed by the Scheduler::run at the own duration of a press, debounced after the
+    // co_await (any API with the debounce of the button sets the press start, no long-time press API needed).
+    GestureAwaiter long_press(std::chrono::milliseconds duration = std::chrono::milliseconds(BUTTON_CORO_LONG_PRESS_MS)) const
+    {
+        return GestureAwaiter(button, Await::LongPress, 1, (int64_t)duration.count() * 1000);
+    }
+
+    // Presses series of the exact presses quantity
+    GestureAwaiter clicks(uint8_t presses_quantity) const
+    {
+        return GestureAwaiter(button, Await::Clicks, presses_quantity, 0);
+    }
+
+private:
+
+    button_ctx *button;
+};
+
+// =========================================================================================== AWAITERS
+
+} // namespace button_control
+
+
+#endif // BUTTON_CONTROL_CORO_HPP
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+#include <my_libs/button_control/button_control_coro.hpp>
+
+using namespace button_control;
+using namespace std::chrono_literals;
+
+static button_ctx but_menu;
+static button_ctx but_ok;
+
+static AwaitButton menu(but_menu);
+static AwaitButton ok(but_ok);
+
+// Linear UI flow instead of the state flags
+static Task settings_flow()
+{
+    while (true)
+    {
+        co_await menu.long_press(3s);
+        show_settings();
+
+        button_event event = co_await ok.clicks(2);
+        save_settings(event.time_us);
+
+        co_await menu.pressed();
+        show_main_screen();
+    }
+}
+
+extern "C" void app_main()
+{
+    but_menu = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    but_ok = button_initialization(GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX);
+
+    Scheduler::start();
+
+    if (!settings_flow()) printf("No free coroutine frame (BUTTON_CORO_FRAMES / BUTTON_CORO_FRAME_SIZE)\n");
+
+    while (true)
+    {
+        button_bank_sample();
+
+        // The APIs detect the gestures and report the events
+        callback_control_by_but_onetime_press(&but_menu, 1);
+        callback_control_by_but_longtime_press(&but_menu, 1);
+        callback_control_by_but_multiple_press(&but_ok, 2, 1);
+
+        // Resume the coroutines with the happened gestures
+        Scheduler::run();
+
+        await(1, TIME_UNIT_MS);
+    }
+}
+
+// Simulated clock: Scheduler::run() follows the button engine time, so the trace replay on the virtual
+// clock or button_time_source_set + button_input_source_set (BUTTON_CONTROL_SIM_INPUT) drive it as well.
+// Host program of the simulated clock: tools/host/button_host_coro.cpp (build: tools/host/build.sh)
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
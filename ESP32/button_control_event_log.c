@@ -0,0 +1,350 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - compact persistent event log (С-File)
+
+// Author: dimakomplekt
+
+// Description: Packed button events in the RAM staging page, closed full pages are written to the storage
+// by the flush outside the button APIs (decoder - button_control_event_log_decode.c).
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include "button_control_event_log.h"
+
+#include <string.h>
+
+#if !BUTTON_CONTROL_EVENTS
+    #error "button_control_event_log requires BUTTON_CONTROL_EVENTS 1"
+#endif
+
+// Page format keeps the event type in 3 bits of the head
+_Static_assert(BUTTON_EVENT_QUANTITY <= BUT_EVENT_LOG_HEAD_TYPE_MASK + 1, "Event type does not fit the log head");
+_Static_assert(BUTTON_EVENT_MULTIPLE_PRESS == BUT_EVENT_LOG_TYPE_MULTIPLE, "Decoder type of the multiple press");
+_Static_assert(BUTTON_EVENT_LONG_PRESS == BUT_EVENT_LOG_TYPE_LONG, "Decoder type of the long press");
+_Static_assert(BUTTON_EVENT_INFINITE_PRESS_START == BUT_EVENT_LOG_TYPE_INFINITE_START, "Decoder type of the infinite press");
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+// Unsigned LEB128 varint write, returns the written bytes
+static uint32_t log_varint_write(uint8_t *out, uint32_t value)
+{
+    uint32_t size = 0;
+
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+
+        out[size++] = byte | (value ? 0x80 : 0x00);
+    }
+    while (value);
+
+    return size;
+}
+
+
+static inline void log_write_u16(uint8_t *out, uint16_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+
+static inline void log_write_u32(uint8_t *out, uint32_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+
+// Empty staging page with the base time
+static void log_page_start(button_event_log *log, uint32_t base_time)
+{
+    log->page[0] = 'B';
+    log->page[1] = 'L';
+    log->page[2] = BUT_EVENT_LOG_VERSION;
+    log->page[3] = BUTTON_LONG_PRESS_S;        // Base of the long press holds
+
+    log_write_u32(&log->page[4], log->sequence);
+    log_write_u32(&log->page[8], base_time);
+
+    log->used = BUT_EVENT_LOG_HEADER_SIZE;
+    log->page_events = 0;
+    log->page_pins_quantity = 0;
+    log->last_time = base_time;
+}
+
+
+// Index of the pin in the staging page dictionary, BUT_EVENT_LOG_PIN_NEW if the pin byte is written
+static uint8_t log_page_pin_index(const button_event_log *log, uint8_t PIN)
+{
+    for (uint8_t i = 0; i < log->page_pins_quantity; i++)
+    {
+        if (log->page_pins[i] == PIN) return i;
+    }
+
+    return BUT_EVENT_LOG_PIN_NEW;
+}
+
+
+// Close the staging page: counts in the header, swap with the full page and report it to the flush
+// (the caller checked, that the full page is free)
+static void log_page_close(button_event_log *log)
+{
+    log_write_u16(&log->page[12], (uint16_t)(log->used - BUT_EVENT_LOG_HEADER_SIZE));
+    log_write_u16(&log->page[14], log->page_events);
+
+    // Unused tail is filled like erased flash
+    memset(&log->page[log->used], 0xFF, log->page_size - log->used);
+
+    uint8_t *full_page = log->page;
+
+    log->page = log->full_page;
+    log->full_page = full_page;
+    log->full_slot = log->next_slot;
+
+    log->next_slot = (log->next_slot + 1) % log->pages_quantity;
+    log->sequence += 1;
+    log->page_events = 0;
+    log->used = BUT_EVENT_LOG_HEADER_SIZE;
+
+    // Page data and its slot are visible before the flag
+    atomic_store_explicit(&log->full_pending, true, memory_order_release);
+}
+
+
+// Listener for the button events
+static void log_event_listener(const button_event *event, void *user)
+{
+    button_event_log_push((button_event_log *)user, event);
+}
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== API REALIZATION
+
+bool button_event_log_init(button_event_log *log, uint8_t *page, uint8_t *full_page, uint32_t page_size,
+                           uint32_t pages_quantity, button_event_log_page_writer writer, void *writer_user,
+                           uint32_t first_sequence)
+{
+    // Error handler
+    if (page == NULL || full_page == NULL || page == full_page) return false;
+    if (page_size < BUT_EVENT_LOG_HEADER_SIZE + BUT_EVENT_LOG_EVENT_MAX_SIZE) return false;
+    if (page_size > UINT16_MAX + BUT_EVENT_LOG_HEADER_SIZE || pages_quantity < 1) return false;
+
+    memset(log, 0, sizeof(*log));
+
+    log->page = page;
+    log->full_page = full_page;
+    log->page_size = page_size;
+    log->pages_quantity = pages_quantity;
+    log->sequence = first_sequence;
+    log->next_slot = first_sequence % pages_quantity;     // Ring slot follows the sequence
+
+    log->writer = writer;
+    log->writer_user = writer_user;
+
+    log->used = BUT_EVENT_LOG_HEADER_SIZE;     // Page is started by the first event
+
+    atomic_init(&log->full_pending, false);
+
+    return true;
+}
+
+
+bool button_event_log_attach(button_event_log *log)
+{
+    return button_event_listener_add(log_event_listener, log);
+}
+
+
+void button_event_log_push(button_event_log *log, const button_event *event)
+{
+    uint32_t time = (uint32_t)(event->time_us / (BUT_EVENT_LOG_TIME_UNIT_MS * 1000));
+
+    // Full page - closed for the flush (no storage access inside the button APIs)
+    if (log->page_events > 0 && (log->used + BUT_EVENT_LOG_EVENT_MAX_SIZE > log->page_size ||
+                                 log->page_events == UINT16_MAX))
+    {
+        // Previous full page is not written yet - the event is lost, the buttons never wait
+        if (atomic_load_explicit(&log->full_pending, memory_order_acquire))
+        {
+            log->events_dropped += 1;
+            return;
+        }
+
+        log_page_close(log);
+    }
+
+    if (log->page_events == 0) log_page_start(log, time);
+
+    // Value: presses quantity, hold over the long press duration or hold duration
+    uint32_t hold = event->hold_ms / BUT_EVENT_LOG_TIME_UNIT_MS;
+    uint32_t value;
+
+    if (event->type == BUTTON_EVENT_MULTIPLE_PRESS) value = event->count;
+    else if (event->type == BUTTON_EVENT_LONG_PRESS || event->type == BUTTON_EVENT_INFINITE_PRESS_START)
+    {
+        int32_t over = (int32_t)hold - BUTTON_LONG_PRESS_S * (1000 / BUT_EVENT_LOG_TIME_UNIT_MS);
+
+        value = ((uint32_t)over << 1) ^ (uint32_t)(over >> 31);                 // Zigzag
+    }
+    else value = hold;
+
+    uint8_t PIN = (uint8_t)event->PIN;
+    uint8_t pin_index = log_page_pin_index(log, PIN);
+
+    uint8_t head = ((uint8_t)event->type & BUT_EVENT_LOG_HEAD_TYPE_MASK) |
+                   (uint8_t)(pin_index << BUT_EVENT_LOG_HEAD_PIN_SHIFT) | (value ? BUT_EVENT_LOG_HEAD_VALUE : 0);
+
+    log->page[log->used++] = head;
+
+    // New pin: the pin byte, it takes the next dictionary index on both sides
+    if (pin_index == BUT_EVENT_LOG_PIN_NEW)
+    {
+        log->page[log->used++] = PIN;
+
+        if (log->page_pins_quantity < BUT_EVENT_LOG_PAGE_PINS) log->page_pins[log->page_pins_quantity++] = PIN;
+    }
+
+    log->used += log_varint_write(&log->page[log->used], time - log->last_time);
+
+    if (value) log->used += log_varint_write(&log->page[log->used], value);
+
+    log->last_time = time;
+    log->page_events += 1;
+    log->events_logged += 1;
+}
+
+
+bool button_event_log_close(button_event_log *log)
+{
+    // Nothing to close
+    if (log->page_events == 0) return true;
+
+    if (atomic_load_explicit(&log->full_pending, memory_order_acquire)) return false;
+
+    log_page_close(log);
+
+    return true;
+}
+
+
+bool button_event_log_pending(button_event_log *log)
+{
+    return atomic_load_explicit(&log->full_pending, memory_order_acquire);
+}
+
+
+bool button_event_log_flush(button_event_log *log)
+{
+    // Nothing to write
+    if (!atomic_load_explicit(&log->full_pending, memory_order_acquire)) return true;
+
+    bool written = (log->writer != NULL) &&
+                   log->writer(log->full_slot, log->full_page, log->page_size, log->writer_user);
+
+    if (written) log->pages_written += 1;
+    else log->write_errors += 1;
+
+    // Full page is free for the next close anyway: the log never blocks the buttons
+    atomic_store_explicit(&log->full_pending, false, memory_order_release);
+
+    return written;
+}
+
+// =========================================================================================== API REALIZATION
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+// Device: 16 flash sectors of the "btnlog" data partition, one sector per page. The events are packed
+// inside the button APIs, the flash is erased / written only by the log task.
+
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <my_libs/button_control/button_control_event_log.h>
+
+static const esp_partition_t *log_partition;
+static uint8_t log_pages[2][4096];              // Staging page + full page
+static button_event_log event_log;
+
+// Never called from the button task: the sector erase stalls the caller for tens of ms
+static bool flash_page_writer(uint32_t page_slot, const uint8_t *page, uint32_t size, void *user)
+{
+    uint32_t offset = page_slot * size;
+
+    if (esp_partition_erase_range(log_partition, offset, size) != ESP_OK) return false;
+
+    return esp_partition_write(log_partition, offset, page, size) == ESP_OK;
+}
+
+// Log task: writes the closed pages (a 4 KB page holds ~1300 events, 100 ms is far below its fill time)
+static void log_task(void *parameter)
+{
+    while (true)
+    {
+        if (button_event_log_pending(&event_log)) button_event_log_flush(&event_log);
+
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+}
+
+void initialization()
+{
+    log_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "btnlog");
+
+    // Continue the ring after the restart: the biggest stored sequence + 1 (the pages are written in order)
+    uint32_t first_sequence = 0;
+
+    for (uint32_t slot = 0; slot < 16; slot++)
+    {
+        uint32_t sequence;
+
+        esp_partition_read(log_partition, slot * sizeof(log_pages[0]), log_pages[0], BUT_EVENT_LOG_HEADER_SIZE);
+
+        if (button_event_log_page_sequence(log_pages[0], sizeof(log_pages[0]), &sequence) &&
+            sequence + 1 > first_sequence)
+        {
+            first_sequence = sequence + 1;
+        }
+    }
+
+    // First page goes to the slot first_sequence % 16 - the oldest page is overwritten
+    button_event_log_init(&event_log, log_pages[0], log_pages[1], sizeof(log_pages[0]), 16, flash_page_writer, NULL,
+                          first_sequence);
+    button_event_log_attach(&event_log);
+
+    xTaskCreate(log_task, "button_log", 3072, NULL, 2, NULL);
+}
+
+// Before esp_deep_sleep_start() / esp_restart() - in the button task, after its last API call:
+// the last events are closed into the full page and the log task writes it
+while (!button_event_log_close(&event_log)) vTaskDelay(1);      // Previous page is being written
+while (button_event_log_pending(&event_log)) vTaskDelay(1);
+
+
+// PC: the partition dump is decoded by the host tool (standalone decoder, no ESP-IDF):
+//
+//   cc -O2 -I. tools/button_event_log_dump.c button_control_event_log_decode.c -o button_event_log_dump
+//   esptool.py read_flash <partition offset> <partition size> btnlog.bin
+//   ./button_event_log_dump btnlog.bin 4096
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
@@ -0,0 +1,138 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - compact persistent event log (Header File, C version)
+
+// Author: dimakomplekt
+
+// Description: Keeps the last button events (pin, type, count, hold duration) for the post-mortem
+// analysis. Events are packed into the RAM staging page (one byte of type + page pin index, varint delta
+// time and value, 3 bytes per typical press) and the full pages are written by the user page writer
+// (flash partition, file and so on) in a ring of pages. The events come inside the button API calls, so
+// the full page is only closed there (double buffer, no storage access): the writer is called by
+// button_event_log_flush from the own task / loop, never from the task of the button APIs. The page format and its decoder are in the
+// standalone button_control_event_log_decode module, so the same code reads the log on the device and
+// on the PC (tools/button_event_log_dump.c).
+
+// Requires BUTTON_CONTROL_EVENTS 1.
+
+// Instruction - at the end of the C-file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_EVENT_LOG_H
+#define BUTTON_CONTROL_EVENT_LOG_H
+
+// =========================================================================================== IMPORT
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "button_control.h"
+#include "button_control_event_log_decode.h"    // Page format, decoder and the decoded record
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#define BUT_EVENT_LOG_EVENT_MAX_SIZE 12         // Head + pin byte + two 32-bit varints
+
+// =========================================================================================== DEFINES
+
+
+// =========================================================================================== EXT STRUCTS
+
+// Page writer type: write the full page into the page slot (0 .. pages_quantity - 1) of the storage.
+// Erase of the slot (if the storage needs it) is the writer job. Returns false on the write error.
+// Called only by button_event_log_flush (flash erase takes tens of ms - keep it out of the button task).
+typedef bool (*button_event_log_page_writer)(uint32_t page_slot, const uint8_t *page, uint32_t size, void *user);
+
+// Event log structure
+typedef struct
+{
+    uint8_t *page;                              // RAM staging page (user buffer, filled by the events)
+    uint8_t *full_page;                         // RAM full page, waiting for the writer (user buffer)
+    uint32_t page_size;                         // Page size (flash sector size for the flash storage)
+    uint32_t used;                              // Used bytes of the staging page (header included)
+    uint16_t page_events;                       // Events in the staging page
+
+    uint32_t pages_quantity;                    // Page slots in the storage ring
+    uint32_t next_slot;                         // Storage slot for the next closed page
+    uint32_t sequence;                          // Sequence number of the staging page
+
+    uint32_t full_slot;                         // Storage slot of the full page
+    atomic_bool full_pending;                   // Full page is closed and waits for the flush
+
+    uint32_t last_time;                         // Previous event time (10 ms)
+
+    uint8_t page_pins[BUT_EVENT_LOG_PAGE_PINS]; // Pin dictionary of the staging page
+    uint8_t page_pins_quantity;
+
+    button_event_log_page_writer writer;        // Storage writer
+    void *writer_user;                          // User pointer for the writer
+
+    uint32_t events_logged;                     // Statistics
+    uint32_t events_dropped;                    // Staging page was full and the full page was not written yet
+    uint32_t pages_written;
+    uint32_t write_errors;
+
+} button_event_log;
+
+// =========================================================================================== EXT STRUCTS
+
+
+// =========================================================================================== API
+
+// Function: button_event_log_init
+// Purpose: Attach the RAM pages and the storage writer to the log and reset it. page and full_page - two
+// buffers of page_size (the events fill one while the other waits for the writer).
+// first_sequence - continue the numbering after the restart (the last stored sequence + 1, or 0),
+// the first page goes to the slot first_sequence % pages_quantity (the slot after the last stored page).
+// Returns false if the pages are missing or too small.
+// Call as: button_event_log_init(&log, pages[0], pages[1], sizeof(pages[0]), 16, flash_page_writer, NULL, 0);
+bool button_event_log_init(button_event_log *log, uint8_t *page, uint8_t *full_page, uint32_t page_size,
+                           uint32_t pages_quantity, button_event_log_page_writer writer, void *writer_user,
+                           uint32_t first_sequence);
+
+
+// Function: button_event_log_attach
+// Purpose: Subscribe the log to the button events (one of the BUTTON_EVENT_LISTENERS_MAX slots).
+// Call as: button_event_log_attach(&log);
+bool button_event_log_attach(button_event_log *log);
+
+
+// Function: button_event_log_push
+// Purpose: Pack one event into the staging page. The full staging page is closed into the full page
+// (pointer swap, button_event_log_pending becomes true) - the storage is not touched here. If the previous
+// full page is not written yet, the event is dropped (events_dropped).
+// Called by the attached listener (inside the button APIs), can be called directly for the own events.
+// Call as: button_event_log_push(&log, &event);
+void button_event_log_push(button_event_log *log, const button_event *event);
+
+
+// Function: button_event_log_close
+// Purpose: Close the staging page with the events now (before the sleep / reboot), the next events go to
+// the next page. No storage access - call it from the task of the button APIs, then flush.
+// Returns false if the previous full page is not written yet (flush first).
+// Call as: button_event_log_close(&log);
+bool button_event_log_close(button_event_log *log);
+
+
+// Function: button_event_log_pending
+// Purpose: Full page waits for the writer (check it in the log task / loop and flush).
+// Call as: if (button_event_log_pending(&log)) button_event_log_flush(&log);
+bool button_event_log_pending(button_event_log *log);
+
+
+// Function: button_event_log_flush
+// Purpose: Write the full page to the storage by the page writer, if it waits. Call outside the task of
+// the button APIs (log task, idle loop): the writer may erase the flash. One flush caller per log.
+// Returns false on the write error (the page is released anyway - the log never blocks the buttons).
+// Call as: button_event_log_flush(&log);
+bool button_event_log_flush(button_event_log *log);
+
+// =========================================================================================== API
+
+
+#endif // BUTTON_CONTROL_EVENT_LOG_H
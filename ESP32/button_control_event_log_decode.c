@@ -0,0 +1,187 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - event log page decoder (С-File)
+
+// Author: dimakomplekt
+
+// Description: Standalone decoder of the event log pages (device and host builds).
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include "button_control_event_log_decode.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+// Unsigned LEB128 varint read, returns the read bytes or 0 if the varint is broken
+static uint32_t log_varint_read(const uint8_t *data, uint32_t length, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t size = 0; size < length && size < 5; size++)
+    {
+        result |= (uint32_t)(data[size] & 0x7F) << (7 * size);
+
+        if (!(data[size] & 0x80))
+        {
+            *value = result;
+            return size + 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static inline uint16_t log_read_u16(const uint8_t *data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+
+static inline uint32_t log_read_u32(const uint8_t *data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== API REALIZATION
+
+int button_event_log_page_sequence(const uint8_t *page, uint32_t size, uint32_t *sequence)
+{
+    // Error handler
+    if (size < BUT_EVENT_LOG_HEADER_SIZE) return 0;
+    if (page[0] != 'B' || page[1] != 'L' || page[2] != BUT_EVENT_LOG_VERSION) return 0;
+    if (log_read_u16(&page[12]) > size - BUT_EVENT_LOG_HEADER_SIZE) return 0;
+
+    if (sequence) *sequence = log_read_u32(&page[4]);
+
+    return 1;
+}
+
+
+int32_t button_event_log_decode_page(const uint8_t *page, uint32_t size, button_event_log_decoder decoder,
+                                     void *user)
+{
+    button_event_log_record record;
+
+    // Error handler
+    if (!button_event_log_page_sequence(page, size, &record.sequence)) return -1;
+
+    uint32_t data_size = log_read_u16(&page[12]);
+    uint16_t events = log_read_u16(&page[14]);
+
+    uint32_t time = log_read_u32(&page[8]);
+    uint32_t long_press = page[3] * (1000 / BUT_EVENT_LOG_TIME_UNIT_MS);
+    const uint8_t *data = &page[BUT_EVENT_LOG_HEADER_SIZE];
+    uint32_t position = 0;
+
+    // Page pin dictionary
+    uint8_t pins[BUT_EVENT_LOG_PAGE_PINS];
+    uint8_t pins_quantity = 0;
+
+    for (uint16_t i = 0; i < events; i++)
+    {
+        uint32_t dt;
+        uint32_t value = 0;
+        uint32_t read;
+
+        if (position >= data_size) return -1;
+
+        uint8_t head = data[position++];
+        uint8_t pin_index = (head >> BUT_EVENT_LOG_HEAD_PIN_SHIFT) & 0x0F;
+
+        if (pin_index == BUT_EVENT_LOG_PIN_NEW)
+        {
+            if (position >= data_size) return -1;
+
+            record.PIN = data[position++];
+
+            if (pins_quantity < BUT_EVENT_LOG_PAGE_PINS) pins[pins_quantity++] = record.PIN;
+        }
+        else
+        {
+            if (pin_index >= pins_quantity) return -1;
+
+            record.PIN = pins[pin_index];
+        }
+
+        read = log_varint_read(&data[position], data_size - position, &dt);
+        if (read == 0) return -1;
+        position += read;
+
+        if (head & BUT_EVENT_LOG_HEAD_VALUE)
+        {
+            read = log_varint_read(&data[position], data_size - position, &value);
+            if (read == 0) return -1;
+            position += read;
+        }
+
+        time += dt;
+
+        record.time_ms = time * BUT_EVENT_LOG_TIME_UNIT_MS;
+        record.type = head & BUT_EVENT_LOG_HEAD_TYPE_MASK;
+
+        if (record.type == BUT_EVENT_LOG_TYPE_MULTIPLE)
+        {
+            record.count = (uint8_t)value;
+            record.hold_ms = 0;
+        }
+        else if (record.type == BUT_EVENT_LOG_TYPE_LONG || record.type == BUT_EVENT_LOG_TYPE_INFINITE_START)
+        {
+            int32_t over = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);    // Zigzag
+
+            record.count = 1;
+            record.hold_ms = (uint32_t)((int32_t)long_press + over) * BUT_EVENT_LOG_TIME_UNIT_MS;
+        }
+        else
+        {
+            record.count = 1;
+            record.hold_ms = value * BUT_EVENT_LOG_TIME_UNIT_MS;
+        }
+
+        if (decoder) decoder(&record, user);
+    }
+
+    return events;
+}
+
+// =========================================================================================== API REALIZATION
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+// Device: decode the staging page or a page read back from the storage
+
+#include <my_libs/button_control/button_control_event_log.h>    // Includes the decoder header
+
+static void print_record(const button_event_log_record *record, void *user)
+{
+    printf("%u ms\tpin %u\ttype %u\tcount %u\thold %u ms\n", record->time_ms, record->PIN, record->type,
+           record->count, record->hold_ms);
+}
+
+button_event_log_decode_page(event_log.page, event_log.page_size, print_record, NULL);
+
+
+// Host: only this C-file and its header are needed, the ready tool is tools/button_event_log_dump.c
+//
+//   cc -O2 -I. tools/button_event_log_dump.c button_control_event_log_decode.c -o button_event_log_dump
+//   esptool.py read_flash <partition offset> <partition size> btnlog.bin
+//   ./button_event_log_dump btnlog.bin 4096
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
@@ -0,0 +1,110 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - event log page decoder (Header File, C version)
+
+// Author: dimakomplekt
+
+// Description: Standalone decoder of the button_control_event_log pages. Depends only on <stdint.h>,
+// so the same files are built into the device firmware and into the host tools
+// (see tools/button_event_log_dump.c).
+
+// Page format (little endian):
+//
+//   header:  'B' 'L' <version> <long press, s> <sequence:u32> <base time, 10 ms:u32> <data bytes:u16> <events:u16>
+//   event:   <head:u8> [<pin:u8>] <dt, 10 ms:varint> [<value:varint>]
+//
+//            head bits 0..2 - event type (button_event_type)
+//            head bits 3..6 - pin index in the page pin dictionary,
+//                             BUT_EVENT_LOG_PIN_NEW - the pin number byte follows the head
+//            head bit 7     - value follows (no value - 0)
+//
+//            value - presses quantity for BUTTON_EVENT_MULTIPLE_PRESS,
+//                    zigzag of (hold - long press duration) in 10 ms for BUTTON_EVENT_LONG_PRESS and
+//                    BUTTON_EVENT_INFINITE_PRESS_START (they are reported right at the long press deadline),
+//                    hold duration in 10 ms for others
+//
+// The page pin dictionary is empty at the page start, every new pin byte takes the next index
+// (up to BUT_EVENT_LOG_PAGE_PINS pins, the later new pins are written by the pin byte every time).
+// dt of the first page event is counted from the page base time.
+
+// Typical press: head + 1 byte of dt + 1 byte of hold, 3 bytes per event; long press at the deadline: 2 bytes.
+// Measured: 8 buttons, 4 x 10 min of the bench presses (onetime / multiple / long / infinite APIs, chatter
+// model) - 10920 events, 33664 data bytes, 3.08 bytes per event. Reproduce on the host:
+// tools/host/build.sh && tools/host/button_host_bench event_log 600000 btnlog.bin, then
+// tools/button_event_log_dump btnlog.bin.
+
+// Instruction - at the end of the C-file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_EVENT_LOG_DECODE_H
+#define BUTTON_CONTROL_EVENT_LOG_DECODE_H
+
+// =========================================================================================== IMPORT
+
+#include <stdint.h>
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#define BUT_EVENT_LOG_VERSION 2                 // Page format version
+#define BUT_EVENT_LOG_HEADER_SIZE 16            // Page header size
+#define BUT_EVENT_LOG_TIME_UNIT_MS 10           // Timestamps and hold durations resolution
+
+#define BUT_EVENT_LOG_PAGE_PINS 15              // Pin dictionary size of one page
+#define BUT_EVENT_LOG_PIN_NEW 15                // Head pin index: the pin number byte follows
+
+#define BUT_EVENT_LOG_HEAD_TYPE_MASK 0x07       // Head bits
+#define BUT_EVENT_LOG_HEAD_PIN_SHIFT 3
+#define BUT_EVENT_LOG_HEAD_VALUE 0x80
+
+#define BUT_EVENT_LOG_TYPE_MULTIPLE 1           // BUTTON_EVENT_MULTIPLE_PRESS (value - presses quantity)
+#define BUT_EVENT_LOG_TYPE_LONG 2               // BUTTON_EVENT_LONG_PRESS (value - hold over the long press)
+#define BUT_EVENT_LOG_TYPE_INFINITE_START 3     // BUTTON_EVENT_INFINITE_PRESS_START (the same)
+
+// =========================================================================================== DEFINES
+
+
+// =========================================================================================== EXT STRUCTS
+
+// Decoded event structure
+typedef struct
+{
+    uint32_t sequence;                          // Page sequence number
+    uint32_t time_ms;                           // Event time from the boot (10 ms resolution)
+
+    uint8_t PIN;                                // Source button pin (gpio_num_t)
+    uint8_t type;                               // Event type (button_event_type)
+    uint8_t count;                              // Presses quantity
+    uint32_t hold_ms;                           // Hold duration (10 ms resolution)
+
+} button_event_log_record;
+
+// Decoder callback type
+typedef void (*button_event_log_decoder)(const button_event_log_record *record, void *user);
+
+// =========================================================================================== EXT STRUCTS
+
+
+// =========================================================================================== API
+
+// Function: button_event_log_page_sequence
+// Purpose: Check the page header and read its sequence number (order of the ring pages).
+// Returns 0 if the page is not an event log page (erased / broken), 1 otherwise.
+// Call as: if (button_event_log_page_sequence(page, size, &sequence)) ...
+int button_event_log_page_sequence(const uint8_t *page, uint32_t size, uint32_t *sequence);
+
+
+// Function: button_event_log_decode_page
+// Purpose: Decode all the events of the raw page (from the storage or the staging page).
+// Returns the decoded events quantity, or -1 if the page is erased or broken.
+// Call as: button_event_log_decode_page(page, size, print_record, NULL);
+int32_t button_event_log_decode_page(const uint8_t *page, uint32_t size, button_event_log_decoder decoder,
+                                     void *user);
+
+// =========================================================================================== API
+
+
+#endif // BUTTON_CONTROL_EVENT_LOG_DECODE_H
@@ -0,0 +1,290 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - dual-core sampler task and event queue (С-File)
+
+// Author: dimakomplekt
+
+// Description: Pinned sampler task with the fixed pass rate and the lock-free SPSC event queues
+// (C11 atomics, acquire / release on the ring positions, task notify for the consumer wakeup).
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include "button_control_task.h"
+
+#include "esp_timer.h"                          // For esp_timer_get_time()
+
+#if !BUTTON_CONTROL_EVENTS
+    #error "button_control_task requires BUTTON_CONTROL_EVENTS 1"
+#endif
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+// Listener for the button events (called inside the sampler task)
+static void BUT_IRAM_ATTR queue_event_listener(const button_event *event, void *user)
+{
+    button_event_queue_push((button_event_queue *)user, event);
+}
+
+
+// Sampler task body
+static void sampler_task(void *parameter)
+{
+    button_sampler *sampler = (button_sampler *)parameter;
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t period_us = sampler->period_us;
+
+    while (!sampler->stop_request)
+    {
+        int64_t pass_start_us = esp_timer_get_time();
+
+        button_bank_sample();
+        sampler->poll(sampler->poll_user);
+
+        int64_t pass_us = esp_timer_get_time() - pass_start_us;
+
+        if (pass_us > sampler->pass_max_us) sampler->pass_max_us = pass_us;
+        if (pass_us > period_us) sampler->overruns += 1;
+
+        sampler->passes += 1;
+
+        // Fixed rate: the next pass is counted from the previous wakeup, not from the pass end
+        vTaskDelayUntil(&last_wake, sampler->period_ticks);
+    }
+
+    sampler->task = NULL;
+    vTaskDelete(NULL);
+}
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== API REALIZATION
+
+bool button_event_queue_init(button_event_queue *queue, button_event *events, uint32_t capacity, TaskHandle_t consumer)
+{
+    // Error handler
+    if (events == NULL || capacity < 2 || (capacity & (capacity - 1)) != 0) return false;
+
+    queue->events = events;
+    queue->mask = capacity - 1;
+    queue->consumer = consumer;
+
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->pushed, 0);
+    atomic_init(&queue->dropped, 0);
+
+    queue->received = 0;
+    queue->latency_total_us = 0;
+    queue->latency_max_us = 0;
+
+    return true;
+}
+
+
+void button_event_queue_consumer_set(button_event_queue *queue, TaskHandle_t consumer)
+{
+    queue->consumer = consumer;
+}
+
+
+bool button_event_queue_attach(button_event_queue *queue)
+{
+    return button_event_listener_add(queue_event_listener, queue);
+}
+
+
+void button_event_queue_detach(button_event_queue *queue)
+{
+    button_event_listener_remove(queue_event_listener, queue);
+}
+
+
+bool BUT_IRAM_ATTR button_event_queue_push(button_event_queue *queue, const button_event *event)
+{
+    uint_fast32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint_fast32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    // Full queue - the sampler never waits for the consumer
+    if (tail - head > queue->mask)
+    {
+        atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    queue->events[tail & queue->mask] = *event;
+
+    // Event data is visible before the new tail
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    atomic_fetch_add_explicit(&queue->pushed, 1, memory_order_relaxed);
+
+    // One read: the consumer may register itself from the other core (button_event_queue_consumer_set)
+    TaskHandle_t consumer = queue->consumer;
+
+    if (consumer == NULL) return true;
+
+    // Producer may be the IRAM-safe timer ISR (BUTTON_CONTROL_IRAM)
+    if (xPortInIsrContext())
+    {
+        BaseType_t higher_priority_woken = pdFALSE;
+
+        vTaskNotifyGiveFromISR(consumer, &higher_priority_woken);
+
+        if (higher_priority_woken) portYIELD_FROM_ISR();
+    }
+    else xTaskNotifyGive(consumer);
+
+    return true;
+}
+
+
+bool button_event_queue_receive(button_event_queue *queue, button_event *event, TickType_t wait_ticks)
+{
+    uint_fast32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if (head == atomic_load_explicit(&queue->tail, memory_order_acquire))
+    {
+        if (queue->consumer == NULL || wait_ticks == 0) return false;
+
+        TimeOut_t timeout;
+        vTaskSetTimeOutState(&timeout);
+
+        // Notify of every push is counted, so the push before the take is not lost. The count may be
+        // stale (events already taken without the wait) - then wait again for the rest of the time
+        // (xTaskCheckForTimeOut never expires portMAX_DELAY).
+        do
+        {
+            if (xTaskCheckForTimeOut(&timeout, &wait_ticks) == pdTRUE) return false;
+
+            ulTaskNotifyTake(pdTRUE, wait_ticks);
+        }
+        while (head == atomic_load_explicit(&queue->tail, memory_order_acquire));
+    }
+
+    *event = queue->events[head & queue->mask];
+
+    // Slot is free for the sampler after the copy
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    // Handoff latency
+    int64_t latency_us = esp_timer_get_time() - event->time_us;
+
+    queue->received += 1;
+    queue->latency_total_us += latency_us;
+
+    if (latency_us > queue->latency_max_us) queue->latency_max_us = latency_us;
+
+    return true;
+}
+
+
+bool button_sampler_start(button_sampler *sampler, button_sampler_poll poll, void *user, uint32_t period_ms,
+                          BaseType_t core, uint32_t stack_size, UBaseType_t priority)
+{
+    // Error handler
+    if (poll == NULL) return false;
+
+    // Whole ticks only: pdMS_TO_TICKS truncates (1 ms at 100 Hz would be 0 ticks, 15 ms - 10 ms)
+    uint64_t period_ticks = (uint64_t)period_ms * configTICK_RATE_HZ;
+
+    if (period_ticks == 0 || period_ticks % 1000 != 0) return false;
+
+    sampler->poll = poll;
+    sampler->poll_user = user;
+
+    sampler->period_ticks = (TickType_t)(period_ticks / 1000);
+    sampler->period_us = period_ms * 1000;
+
+    sampler->stop_request = false;
+
+    sampler->passes = 0;
+    sampler->overruns = 0;
+    sampler->pass_max_us = 0;
+
+    if (stack_size == 0) stack_size = BUT_SAMPLER_STACK_SIZE;
+    if (priority == 0) priority = BUT_SAMPLER_PRIORITY;
+
+    return xTaskCreatePinnedToCore(sampler_task, "button_sampler", stack_size, sampler, priority,
+                                   &sampler->task, core) == pdPASS;
+}
+
+
+void button_sampler_stop(button_sampler *sampler)
+{
+    sampler->stop_request = true;
+}
+
+// =========================================================================================== API REALIZATION
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+// Buttons on the core 0, UI on the core 1 (network stack stays on the core 0 under the sampler priority)
+
+#include <my_libs/button_control/button_control_task.h>
+
+static button_ctx but_menu;
+static button_ctx but_ok;
+
+static bool menu_flag = false;
+
+static button_sampler sampler;
+static button_event_queue ui_queue;
+static button_event ui_events[32];
+
+// Sampler task: the button APIs only (bank is sampled before the call)
+static void poll_buttons(void *user)
+{
+    flag_control_by_but_onetime_press(&but_menu, &menu_flag);
+    callback_control_by_but_longtime_press(&but_ok, 1);
+}
+
+// Consumer task: blocks until the event, may be slow (display, network) - the sampler keeps its rate
+static void ui_task(void *parameter)
+{
+    button_event event;
+
+    // Queue is ready before the task: the task only registers itself for the wakeup
+    button_event_queue_consumer_set(&ui_queue, xTaskGetCurrentTaskHandle());
+
+    while (1)
+    {
+        if (!button_event_queue_receive(&ui_queue, &event, portMAX_DELAY)) continue;
+
+        if (event.PIN == GPIO_NUM_4 && event.type == BUTTON_EVENT_ONETIME_PRESS) show_menu();
+        if (event.PIN == GPIO_NUM_5 && event.type == BUTTON_EVENT_LONG_PRESS) confirm();
+    }
+}
+
+void app_main()
+{
+    but_menu = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    but_ok = button_initialization(GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX);
+
+    // Queue first: the UI task may run on the core 1 right after its creation
+    button_event_queue_init(&ui_queue, ui_events, 32, NULL);
+    button_event_queue_attach(&ui_queue);
+
+    xTaskCreatePinnedToCore(ui_task, "ui", 4096, NULL, 5, NULL, 1);
+
+    // 1 ms pass: CONFIG_FREERTOS_HZ=1000 (false for the period, that is not a whole number of ticks)
+    if (!button_sampler_start(&sampler, poll_buttons, NULL, 1, 0, 0, 0)) ESP_LOGE("buttons", "sampler not started");
+}
+
+// Health check: sampler.overruns, sampler.pass_max_us, ui_queue.dropped,
+// ui_queue.latency_max_us, ui_queue.latency_total_us / ui_queue.received
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
@@ -0,0 +1,163 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - dual-core sampler task and event queue (Header File, C version)
+
+// Author: dimakomplekt
+
+// Description: Moves the buttons polling out of the UI / network loop. The sampler task is pinned to
+// one core and runs button_bank_sample + the user poll function (the button APIs) at the fixed rate.
+// Detected events go through the lock-free single producer / single consumer queues to the consumer
+// tasks on the other core, so a busy consumer never delays the presses detection and a late sampler
+// never blocks the consumer.
+
+// One queue per consumer task: the sampler task is the only producer of every queue (the event listener
+// is called from the button APIs inside the sampler), the consumer task is the only reader.
+// A full queue drops the new event and counts it - the sampler never waits for the consumer.
+
+// Button ctxs are owned by the sampler task after the start: consumers use the event data only
+// (PIN, type, count, hold_ms, time_us), not the event.button fields.
+
+// Requires BUTTON_CONTROL_EVENTS 1.
+
+// Instruction - at the end of the C-file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_TASK_H
+#define BUTTON_CONTROL_TASK_H
+
+// =========================================================================================== IMPORT
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "button_control.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#define BUT_SAMPLER_STACK_SIZE 3072             // Default sampler task stack (bytes)
+#define BUT_SAMPLER_PRIORITY 10                 // Default sampler task priority (above the UI / network tasks)
+
+// =========================================================================================== DEFINES
+
+
+// =========================================================================================== EXT STRUCTS
+
+// Sampler poll function type: call the button APIs of all buttons here (bank is sampled before the call)
+typedef void (*button_sampler_poll)(void *user);
+
+// Event queue structure (lock-free SPSC ring of the events)
+typedef struct
+{
+    button_event *events;                       // User events buffer
+    uint32_t mask;                              // Capacity - 1 (capacity is a power of 2)
+
+    atomic_uint_fast32_t tail;                  // Next write position (written by the sampler only)
+    atomic_uint_fast32_t head;                  // Next read position (written by the consumer only)
+
+    TaskHandle_t volatile consumer;             // Consumer task for the wakeup notify (NULL - polling consumer)
+
+    atomic_uint_fast32_t pushed;                // Producer statistics (sampler side)
+    atomic_uint_fast32_t dropped;
+
+    uint32_t received;                          // Consumer statistics (consumer side)
+    int64_t latency_total_us;                   // Event time -> receive time
+    int64_t latency_max_us;
+
+} button_event_queue;
+
+// Sampler task structure
+typedef struct
+{
+    button_sampler_poll poll;                   // User poll function
+    void *poll_user;                            // User pointer for the poll function
+
+    TickType_t period_ticks;                    // Pass period
+    uint32_t period_us;                         // Pass period in us (the period actually used)
+    TaskHandle_t task;                          // Sampler task handle
+    volatile bool stop_request;                 // Stop by button_sampler_stop
+
+    uint32_t passes;                            // Statistics (written by the sampler task only)
+    uint32_t overruns;                          // Passes longer than the period
+    int64_t pass_max_us;                        // Longest pass
+
+} button_sampler;
+
+// =========================================================================================== EXT STRUCTS
+
+
+// =========================================================================================== API
+
+// Function: button_event_queue_init
+// Purpose: Attach the events buffer to the queue and reset it. capacity must be a power of 2.
+// consumer - task for the wakeup notify (xTaskGetCurrentTaskHandle() of the consumer), NULL if
+// the consumer polls the queue without waits or is not created yet (button_event_queue_consumer_set).
+// Returns false if the capacity is wrong.
+// Call as: button_event_queue_init(&ui_queue, ui_events, 32, ui_task_handle);
+bool button_event_queue_init(button_event_queue *queue, button_event *events, uint32_t capacity, TaskHandle_t consumer);
+
+
+// Function: button_event_queue_consumer_set
+// Purpose: Set the consumer task for the wakeup notify after the init (the consumer task registers itself
+// at its start, so the queue is ready before the task is created). Events pushed before it are received
+// without the wait.
+// Call as: button_event_queue_consumer_set(&ui_queue, xTaskGetCurrentTaskHandle());
+void button_event_queue_consumer_set(button_event_queue *queue, TaskHandle_t consumer);
+
+
+// Function: button_event_queue_attach
+// Purpose: Subscribe the queue to the button events (one of the BUTTON_EVENT_LISTENERS_MAX slots).
+// Call before the button_sampler_start.
+// Call as: button_event_queue_attach(&ui_queue);
+bool button_event_queue_attach(button_event_queue *queue);
+
+
+// Function: button_event_queue_detach
+// Purpose: Unsubscribe the queue from the button events (stop the sampler first).
+// Call as: button_event_queue_detach(&ui_queue);
+void button_event_queue_detach(button_event_queue *queue);
+
+
+// Function: button_event_queue_push
+// Purpose: Put one event into the queue (producer side). Called by the attached listener, can be called
+// directly from the producer task for the own events. Works from the IRAM-safe ISR sampler too
+// (BUTTON_CONTROL_IRAM: the consumer is notified by the ISR variant). Returns false if the queue is full
+// (event is dropped).
+// Call as: button_event_queue_push(&ui_queue, &event);
+bool button_event_queue_push(button_event_queue *queue, const button_event *event);
+
+
+// Function: button_event_queue_receive
+// Purpose: Take the oldest event (consumer side). Waits up to wait_ticks for the event (portMAX_DELAY -
+// until the event), if the consumer task was set. Returns false if there is no event after the wait.
+// Call as: while (button_event_queue_receive(&ui_queue, &event, portMAX_DELAY)) { ... }
+bool button_event_queue_receive(button_event_queue *queue, button_event *event, TickType_t wait_ticks);
+
+
+// Function: button_sampler_start
+// Purpose: Create the sampler task pinned to the core: every period_ms it samples the bank and calls
+// the poll function. stack_size / priority - 0 for the BUT_SAMPLER_STACK_SIZE / BUT_SAMPLER_PRIORITY.
+// period_ms must be a whole number of the RTOS ticks (no rounding: 1 ms needs CONFIG_FREERTOS_HZ=1000,
+// the default 100 Hz allows 10, 20, ... ms), the period in use - sampler.period_us.
+// Returns false for the period out of the ticks or if the task is not created.
+// Call as: button_sampler_start(&sampler, poll_buttons, NULL, 1, 0, 0, 0);
+bool button_sampler_start(button_sampler *sampler, button_sampler_poll poll, void *user, uint32_t period_ms,
+                          BaseType_t core, uint32_t stack_size, UBaseType_t priority);
+
+
+// Function: button_sampler_stop
+// Purpose: Stop the sampler task after its current pass (the task deletes itself).
+// Call as: button_sampler_stop(&sampler);
+void button_sampler_stop(button_sampler *sampler);
+
+// =========================================================================================== API
+
+
+#endif // BUTTON_CONTROL_TASK_H
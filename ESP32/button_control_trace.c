@@ -0,0 +1,471 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - raw input trace recorder / replay (С-File)
+
+// Author: dimakomplekt
+
+// Description: {dt, changed pins} records of the latched input bank in a ring buffer, linear export
+// for the file / flash save and the replay back through the button_bank_sample.
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include "button_control_trace.h"
+
+#include <string.h>
+
+#include "esp_timer.h"                          // For esp_timer_get_time() of the real time replay
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== VARIABLES
+
+#if BUTTON_CONTROL_SIM_INPUT
+static button_trace_replay *active_replay = NULL;       // Real time replay for the bank source
+#endif
+
+// =========================================================================================== VARIABLES
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+// Unsigned LEB128 varint write, returns the written bytes
+static uint32_t trace_varint_write(uint8_t *out, uint64_t value)
+{
+    uint32_t size = 0;
+
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+
+        out[size++] = byte | (value ? 0x80 : 0x00);
+    }
+    while (value);
+
+    return size;
+}
+
+
+static inline void trace_toggle_pin(button_bank_snapshot *snapshot, uint8_t pin)
+{
+    if (pin < 32) snapshot->in ^= (uint32_t)1 << pin;
+    else snapshot->in1 ^= (uint32_t)1 << (pin - 32);
+}
+
+
+static inline uint8_t trace_ring_read(const button_trace_recorder *recorder, uint32_t offset)
+{
+    return recorder->buffer[(recorder->head + offset) % recorder->capacity];
+}
+
+
+// Drop the oldest record: its changes go to the base snapshot
+static void trace_drop_oldest(button_trace_recorder *recorder)
+{
+    uint32_t offset = 0;
+
+    // Skip dt varint
+    while (trace_ring_read(recorder, offset++) & 0x80);
+
+    // Apply the pin changes
+    uint8_t pin_byte;
+
+    do
+    {
+        pin_byte = trace_ring_read(recorder, offset++);
+        trace_toggle_pin(&recorder->base, pin_byte & 0x3F);
+    }
+    while (pin_byte & 0x80);
+
+    recorder->head = (recorder->head + offset) % recorder->capacity;
+    recorder->used -= offset;
+    recorder->records -= 1;
+    recorder->dropped_records += 1;
+}
+
+
+static inline void trace_write_u32(uint8_t *out, uint32_t value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+
+static inline uint32_t trace_read_u32(const uint8_t *data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+// Read the dt varint of the next replay record without the position change.
+// Returns the varint bytes or 0 if the record is broken.
+static uint32_t trace_replay_peek_dt(const button_trace_replay *replay, uint64_t *dt_us)
+{
+    uint64_t value = 0;
+    uint32_t size = 0;
+
+    while (replay->position + size < replay->length && size < 10)
+    {
+        uint8_t byte = replay->records[replay->position + size];
+
+        value |= (uint64_t)(byte & 0x7F) << (7 * size);
+        size += 1;
+
+        if (!(byte & 0x80))
+        {
+            *dt_us = value;
+            return size;
+        }
+    }
+
+    return 0;
+}
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== API REALIZATION
+
+// Recorder
+
+bool button_trace_recorder_init(button_trace_recorder *recorder, uint8_t *buffer, uint32_t capacity)
+{
+    // Error handler
+    if (buffer == NULL || capacity < BUT_TRACE_RECORD_MAX_SIZE) return false;
+
+    memset(recorder, 0, sizeof(*recorder));
+
+    recorder->buffer = buffer;
+    recorder->capacity = capacity;
+
+    return true;
+}
+
+
+void button_trace_record(button_trace_recorder *recorder, const button_bank_snapshot *snapshot)
+{
+    // First snapshot - base state only
+    if (!recorder->started)
+    {
+        recorder->base = *snapshot;
+        recorder->last = *snapshot;
+        recorder->last_time_us = button_time_us();
+        recorder->started = true;
+
+        return;
+    }
+
+    uint32_t changed_in = snapshot->in ^ recorder->last.in;
+    uint32_t changed_in1 = snapshot->in1 ^ recorder->last.in1;
+
+    // Nothing to store for the unchanged bank
+    if (!(changed_in | changed_in1)) return;
+
+    int64_t now_us = button_time_us();     // Engine clock: the virtual time of the simulations is recorded too
+
+    // Record build
+    uint8_t record[BUT_TRACE_RECORD_MAX_SIZE];
+    uint32_t size = trace_varint_write(record, (uint64_t)(now_us - recorder->last_time_us));
+
+    for (uint8_t pin = 0; pin < 64; pin++)
+    {
+        uint32_t changed = (pin < 32) ? (changed_in >> pin) & 0x1 : (changed_in1 >> (pin - 32)) & 0x1;
+
+        if (changed) record[size++] = pin | 0x80;
+    }
+
+    record[size - 1] &= 0x7F;   // Last pin byte
+
+    // Free the space by the oldest records
+    while (recorder->capacity - recorder->used < size) trace_drop_oldest(recorder);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        recorder->buffer[(recorder->head + recorder->used + i) % recorder->capacity] = record[i];
+    }
+
+    recorder->used += size;
+    recorder->records += 1;
+
+    recorder->last = *snapshot;
+    recorder->last_time_us = now_us;
+}
+
+
+uint32_t button_trace_export_size(const button_trace_recorder *recorder)
+{
+    return BUT_TRACE_HEADER_SIZE + recorder->used;
+}
+
+
+uint32_t button_trace_export(const button_trace_recorder *recorder, uint8_t *out, uint32_t out_size)
+{
+    uint32_t size = button_trace_export_size(recorder);
+
+    // Error handler
+    if (out_size < size) return 0;
+
+    out[0] = 'B';
+    out[1] = 'T';
+    out[2] = BUT_TRACE_VERSION;
+    out[3] = 0;
+
+    trace_write_u32(&out[4], recorder->base.in);
+    trace_write_u32(&out[8], recorder->base.in1);
+    trace_write_u32(&out[12], recorder->records);
+    trace_write_u32(&out[16], recorder->used);
+
+    for (uint32_t i = 0; i < recorder->used; i++)
+    {
+        out[BUT_TRACE_HEADER_SIZE + i] = trace_ring_read(recorder, i);
+    }
+
+    return size;
+}
+
+
+// Replay
+
+bool button_trace_replay_init(button_trace_replay *replay, const uint8_t *data, uint32_t length)
+{
+    // Error handler
+    if (length < BUT_TRACE_HEADER_SIZE) return false;
+    if (data[0] != 'B' || data[1] != 'T' || data[2] != BUT_TRACE_VERSION) return false;
+
+    uint32_t records_length = trace_read_u32(&data[16]);
+
+    if (records_length > length - BUT_TRACE_HEADER_SIZE) return false;
+
+    memset(replay, 0, sizeof(*replay));
+
+    replay->records = &data[BUT_TRACE_HEADER_SIZE];
+    replay->length = records_length;
+
+    replay->state.in = trace_read_u32(&data[4]);
+    replay->state.in1 = trace_read_u32(&data[8]);
+
+    return true;
+}
+
+
+bool button_trace_replay_next(button_trace_replay *replay, button_bank_snapshot *snapshot, int64_t *time_us)
+{
+    uint64_t dt_us;
+    uint32_t dt_size = trace_replay_peek_dt(replay, &dt_us);
+
+    // Trace end or broken record
+    if (dt_size == 0)
+    {
+        replay->position = replay->length;
+        return false;
+    }
+
+    replay->position += dt_size;
+    replay->time_us += (int64_t)dt_us;
+
+    uint8_t pin_byte = 0x80;
+
+    while ((pin_byte & 0x80) && replay->position < replay->length)
+    {
+        pin_byte = replay->records[replay->position++];
+        trace_toggle_pin(&replay->state, pin_byte & 0x3F);
+    }
+
+    *snapshot = replay->state;
+    *time_us = replay->time_us;
+
+    return true;
+}
+
+
+#if BUTTON_CONTROL_SIM_INPUT
+
+// Bank source of the replay (real time or the virtual clock)
+static void trace_replay_bank_source(button_bank_snapshot *snapshot)
+{
+    button_trace_replay *replay = active_replay;
+    int64_t trace_now_us = replay->virtual_clock ? replay->now_us : esp_timer_get_time() - replay->start_us;
+
+    uint64_t dt_us;
+    button_bank_snapshot next;
+    int64_t next_time_us;
+
+    // Apply all the records up to the current trace time
+    while (trace_replay_peek_dt(replay, &dt_us) && replay->time_us + (int64_t)dt_us <= trace_now_us)
+    {
+        button_trace_replay_next(replay, &next, &next_time_us);
+    }
+
+    *snapshot = replay->state;
+
+    // Back to the GPIO registers after the trace end (the virtual clock runs until the replay stop)
+    if (button_trace_replay_finished(replay) && !replay->virtual_clock)
+    {
+        button_bank_source_set(NULL);
+        active_replay = NULL;
+    }
+}
+
+
+// Engine clock of the virtual replay
+static int64_t trace_replay_time_source(void)
+{
+    return active_replay->now_us;
+}
+
+
+void button_trace_replay_start(button_trace_replay *replay)
+{
+    replay->start_us = esp_timer_get_time() - replay->time_us;
+    replay->virtual_clock = false;
+
+    active_replay = replay;
+    button_bank_source_set(trace_replay_bank_source);
+}
+
+
+void button_trace_replay_start_virtual(button_trace_replay *replay)
+{
+    replay->now_us = replay->time_us;
+    replay->virtual_clock = true;
+
+    active_replay = replay;
+    button_bank_source_set(trace_replay_bank_source);
+    button_time_source_set(trace_replay_time_source);
+}
+
+
+bool button_trace_replay_advance(button_trace_replay *replay, uint32_t step_us)
+{
+    replay->now_us += step_us;
+
+    // All records were taken by the previous samples (the clock still runs for the awaits after them)
+    return !button_trace_replay_finished(replay);
+}
+
+
+void button_trace_replay_stop(button_trace_replay *replay)
+{
+    if (active_replay != replay) return;
+
+    button_bank_source_set(NULL);
+
+    if (replay->virtual_clock) button_time_source_set(NULL);
+
+    active_replay = NULL;
+}
+
+#endif // BUTTON_CONTROL_SIM_INPUT
+
+
+bool button_trace_replay_finished(const button_trace_replay *replay)
+{
+    return replay->position >= replay->length;
+}
+
+// =========================================================================================== API REALIZATION
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+// Field unit: record the last changes of the bank in RAM and dump them by request
+
+static uint8_t trace_buffer[4096];
+static button_trace_recorder recorder;
+
+void initialization()
+{
+    my_but_1 = button_initialization(MY_BUT_VCC_1, GPIO_PULLUP_ONLY, NO_FIX);
+
+    button_trace_recorder_init(&recorder, trace_buffer, sizeof(trace_buffer));
+}
+
+void main_loop(void *pvParameter)
+{
+    while (1)
+    {
+        button_trace_record(&recorder, button_bank_sample());     // One bank read for the whole tick
+
+        flag_control_by_but_onetime_press(&my_but_1, &but_1_onetime_press);
+        flag_control_by_but_longtime_press(&my_but_1, &but_1_longtime_press);
+
+        ...
+    }
+}
+
+void dump_trace(FILE *file)
+{
+    static uint8_t out[4096 + BUT_TRACE_HEADER_SIZE];
+    uint32_t size = button_trace_export(&recorder, out, sizeof(out));
+
+    fwrite(out, 1, size, file);
+}
+
+
+// Bench unit (BUTTON_CONTROL_SIM_INPUT 1): replay the dumped trace through the same loop
+
+button_trace_replay replay;
+
+button_trace_replay_init(&replay, trace_data, trace_size);
+button_trace_replay_start(&replay);
+
+while (!button_trace_replay_finished(&replay))
+{
+    button_bank_sample();
+
+    flag_control_by_but_onetime_press(&my_but_1, &but_1_onetime_press);
+    flag_control_by_but_longtime_press(&my_but_1, &but_1_longtime_press);
+}
+
+
+// Faster than the real time: the engine runs on the virtual clock of the replay, so the awaits and the
+// events repeat the recorded run (same loop period as the recording). The loop goes on after the last
+// record until the end time: the long-time press and the multipress series end after the last edge.
+
+button_trace_replay_init(&replay, trace_data, trace_size);
+button_trace_replay_start_virtual(&replay);
+
+int64_t end_us = INT64_MAX;
+
+do
+{
+    button_bank_sample();
+
+    flag_control_by_but_onetime_press(&my_but_1, &but_1_onetime_press);
+    flag_control_by_but_longtime_press(&my_but_1, &but_1_longtime_press);
+
+    // All records are taken: the longest await after the last change (long-time press + multipress pause)
+    if (!button_trace_replay_advance(&replay, 1000) && end_us == INT64_MAX)
+    {
+        end_us = replay.now_us + (BUTTON_LONG_PRESS_S + 1) * 1000000LL;
+    }
+}
+while (replay.now_us < end_us);
+
+button_trace_replay_stop(&replay);
+
+
+// Simulation with the own clock (no real time): step over the changes by button_trace_replay_next
+
+button_bank_snapshot snapshot;
+int64_t time_us;
+
+while (button_trace_replay_next(&replay, &snapshot, &time_us))
+{
+    printf("%lld us: in %08lx in1 %08lx\n", time_us, snapshot.in, snapshot.in1);
+}
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
@@ -0,0 +1,170 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - raw input trace recorder / replay (Header File, C version)
+
+// Author: dimakomplekt
+
+// Description: Records the changes of the latched input bank (button_bank_sample) into a user ring buffer
+// as compact {dt, changed pins} records and replays them back through the button engine.
+// Only the changes are stored, so an idle bank costs nothing.
+
+// Record format (little endian, exported trace):
+//
+//   header:  'B' 'T' <version> <reserved> <base in:u32> <base in1:u32> <records:u32> <records bytes:u32>
+//   record:  <dt_us:varint> <pin byte>...
+//            pin byte: bits 0..5 - toggled pin number, bit 7 - one more pin byte follows
+//
+// dt_us of the first record is counted from the base snapshot time.
+
+// Instruction - at the end of the C-file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_CONTROL_TRACE_H
+#define BUTTON_CONTROL_TRACE_H
+
+// =========================================================================================== IMPORT
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "button_control.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== DEFINES
+
+#define BUT_TRACE_VERSION 1                     // Exported trace format version
+#define BUT_TRACE_HEADER_SIZE 20                // Exported trace header size
+#define BUT_TRACE_RECORD_MAX_SIZE 74            // 10 bytes of dt varint + 64 pin bytes
+
+// =========================================================================================== DEFINES
+
+
+// =========================================================================================== EXT STRUCTS
+
+// Trace recorder structure (ring buffer of the records, the oldest records are dropped on overflow)
+typedef struct
+{
+    uint8_t *buffer;                            // User ring buffer
+    uint32_t capacity;                          // Ring buffer size (>= BUT_TRACE_RECORD_MAX_SIZE)
+    uint32_t head;                              // Oldest record position
+    uint32_t used;                              // Used bytes
+
+    uint32_t records;                           // Records in the ring
+    uint32_t dropped_records;                   // Records dropped by overflow
+
+    button_bank_snapshot base;                  // Bank state before the oldest record
+    button_bank_snapshot last;                  // Bank state after the newest record
+    int64_t last_time_us;                       // Time of the newest record (or of the base)
+
+    bool started;                               // First snapshot was taken
+
+} button_trace_recorder;
+
+// Trace replay structure (over the exported trace)
+typedef struct
+{
+    const uint8_t *records;                     // Records of the exported trace
+    uint32_t length;                            // Records bytes
+    uint32_t position;                          // Next record position
+
+    button_bank_snapshot state;                 // Current bank state
+    int64_t time_us;                            // Trace time of the current state
+
+    int64_t start_us;                           // Real time replay start (button_trace_replay_start)
+
+    bool virtual_clock;                         // Virtual clock replay (button_trace_replay_start_virtual)
+    int64_t now_us;                             // Virtual clock: current trace time
+
+} button_trace_replay;
+
+// =========================================================================================== EXT STRUCTS
+
+
+// =========================================================================================== API
+
+// Function: button_trace_recorder_init
+// Purpose: Attach the user buffer to the recorder and reset it.
+// Returns false if the buffer is smaller than BUT_TRACE_RECORD_MAX_SIZE.
+// Call as: button_trace_recorder_init(&recorder, trace_buffer, sizeof(trace_buffer));
+bool button_trace_recorder_init(button_trace_recorder *recorder, uint8_t *buffer, uint32_t capacity);
+
+
+// Function: button_trace_record
+// Purpose: Store the snapshot if it differs from the previous one (call once per tick after the
+// button_bank_sample). The first call stores the base state only.
+// Call as: button_trace_record(&recorder, button_bank_sample());
+void button_trace_record(button_trace_recorder *recorder, const button_bank_snapshot *snapshot);
+
+
+// Function: button_trace_export_size
+// Purpose: Return the exported trace size in bytes (header + records).
+// Call as: uint32_t size = button_trace_export_size(&recorder);
+uint32_t button_trace_export_size(const button_trace_recorder *recorder);
+
+
+// Function: button_trace_export
+// Purpose: Write the linear exported trace into the output buffer (for the file / UART / flash save).
+// Returns the written bytes or 0 if the output buffer is too small.
+// Call as: uint32_t size = button_trace_export(&recorder, out, sizeof(out));
+uint32_t button_trace_export(const button_trace_recorder *recorder, uint8_t *out, uint32_t out_size);
+
+
+// Function: button_trace_replay_init
+// Purpose: Parse the exported trace for the replay. Returns false if the trace is broken.
+// Call as: button_trace_replay_init(&replay, trace_data, trace_size);
+bool button_trace_replay_init(button_trace_replay *replay, const uint8_t *data, uint32_t length);
+
+
+// Function: button_trace_replay_next
+// Purpose: Step to the next recorded bank change without any clock (for the own time control
+// in the simulations). Returns false at the trace end.
+// Call as: while (button_trace_replay_next(&replay, &snapshot, &time_us)) { ... }
+bool button_trace_replay_next(button_trace_replay *replay, button_bank_snapshot *snapshot, int64_t *time_us);
+
+
+#if BUTTON_CONTROL_SIM_INPUT
+
+// Function: button_trace_replay_start
+// Purpose: Start the real time replay: the button_bank_sample takes the recorded levels instead of
+// the GPIO registers until the trace end (requires BUTTON_CONTROL_SIM_INPUT 1).
+// Call as: button_trace_replay_start(&replay);
+void button_trace_replay_start(button_trace_replay *replay);
+
+
+// Function: button_trace_replay_start_virtual
+// Purpose: Start the replay on the virtual clock: the button_bank_sample takes the recorded levels and
+// the engine clock (button_time_source_set) is the trace time, moved only by button_trace_replay_advance.
+// Awaits and events of the buttons repeat the recorded run, when the loop period is the same as in the
+// recording - without waiting for the real time. Reset the button ctxs before the start.
+// Call as: button_trace_replay_start_virtual(&replay);
+void button_trace_replay_start_virtual(button_trace_replay *replay);
+
+
+// Function: button_trace_replay_advance
+// Purpose: Move the virtual clock by step_us (one loop period). Returns false if all records were taken
+// by the previous button_bank_sample calls (the clock is moved anyway - keep calling it until the end time,
+// the awaits after the last change must be finished: long-time press, multipress series end).
+// Call as: do { button_bank_sample(); ... button_trace_replay_advance(&replay, 1000); } while (replay.now_us < end_us);
+bool button_trace_replay_advance(button_trace_replay *replay, uint32_t step_us);
+
+
+// Function: button_trace_replay_stop
+// Purpose: Stop the replay: back to the GPIO registers and (virtual replay) to the esp_timer clock.
+// Call as: button_trace_replay_stop(&replay);
+void button_trace_replay_stop(button_trace_replay *replay);
+
+#endif // BUTTON_CONTROL_SIM_INPUT
+
+
+// Function: button_trace_replay_finished
+// Purpose: Return true if all records were replayed (the real time replay is stopped then).
+// Call as: if (button_trace_replay_finished(&replay)) { ... }
+bool button_trace_replay_finished(const button_trace_replay *replay);
+
+// =========================================================================================== API
+
+
+#endif // BUTTON_CONTROL_TRACE_H
@@ -0,0 +1,149 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - event log dump decoder (host tool, С-File)
+
+// Author: dimakomplekt
+
+// Description: Decodes the event log storage dump (flash partition read by esptool.py, log file) on the PC.
+// Pages are printed in the sequence order, so the ring wrap does not matter. The summary line shows the
+// pages, events and the packed bytes per event. Built from this file and the standalone decoder only.
+
+// Build:  cc -O2 -I.. button_event_log_dump.c ../button_control_event_log_decode.c -o button_event_log_dump
+// Run:    ./button_event_log_dump btnlog.bin [page size, 4096]
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "button_control_event_log_decode.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+// Names by the button_event_type order
+static const char *event_type_names[] = {
+
+    "onetime", "multiple", "long", "infinite_start", "infinite_end", "contact_degrading"
+};
+
+
+// Stored page: offset in the dump and its sequence
+typedef struct
+{
+    long offset;
+    uint32_t sequence;
+
+} dump_page;
+
+
+static int dump_page_compare(const void *a, const void *b)
+{
+    uint32_t sequence_a = ((const dump_page *)a)->sequence;
+    uint32_t sequence_b = ((const dump_page *)b)->sequence;
+
+    return (sequence_a > sequence_b) - (sequence_a < sequence_b);
+}
+
+
+static void print_record(const button_event_log_record *record, void *user)
+{
+    (void)user;
+
+    const char *type = (record->type < sizeof(event_type_names) / sizeof(event_type_names[0]))
+                       ? event_type_names[record->type] : "unknown";
+
+    printf("%u\t%u ms\tpin %u\t%s\tcount %u\thold %u ms\n", (unsigned)record->sequence, (unsigned)record->time_ms,
+           (unsigned)record->PIN, type, (unsigned)record->count, (unsigned)record->hold_ms);
+}
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== MAIN
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <dump file> [page size, 4096]\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t page_size = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 4096;
+
+    FILE *file = fopen(argv[1], "rb");
+    uint8_t *page = malloc(page_size);
+
+    if (file == NULL || page == NULL || page_size < BUT_EVENT_LOG_HEADER_SIZE)
+    {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    // Pass 1: event log pages of the dump (erased / foreign pages are skipped)
+    dump_page *pages = NULL;
+    size_t pages_quantity = 0;
+    size_t slots = 0;
+
+    while (fread(page, 1, page_size, file) == page_size)
+    {
+        uint32_t sequence;
+
+        if (button_event_log_page_sequence(page, page_size, &sequence))
+        {
+            dump_page *grown = realloc(pages, (pages_quantity + 1) * sizeof(dump_page));
+            if (grown == NULL) return 1;
+
+            pages = grown;
+            pages[pages_quantity].offset = (long)(slots * page_size);
+            pages[pages_quantity].sequence = sequence;
+            pages_quantity += 1;
+        }
+
+        slots += 1;
+    }
+
+    qsort(pages, pages_quantity, sizeof(dump_page), dump_page_compare);
+
+    // Pass 2: events in the sequence order
+    uint64_t events = 0;
+    uint64_t data_bytes = 0;
+    size_t broken = 0;
+
+    for (size_t i = 0; i < pages_quantity; i++)
+    {
+        fseek(file, pages[i].offset, SEEK_SET);
+
+        if (fread(page, 1, page_size, file) != page_size) break;
+
+        int32_t decoded = button_event_log_decode_page(page, page_size, print_record, NULL);
+
+        if (decoded < 0)
+        {
+            broken += 1;
+            continue;
+        }
+
+        events += (uint64_t)decoded;
+        data_bytes += (uint64_t)(page[12] | (page[13] << 8));
+    }
+
+    fprintf(stderr, "slots %zu, pages %zu, broken %zu, events %llu, data bytes %llu, bytes per event %.2f\n",
+            slots, pages_quantity, broken, (unsigned long long)events, (unsigned long long)data_bytes,
+            events ? (double)data_bytes / (double)events : 0.0);
+
+    free(pages);
+    free(page);
+    fclose(file);
+
+    return broken ? 1 : 0;
+}
+
+// =========================================================================================== MAIN
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+
+# =========================================================================================== INFO
+
+# ESP32 library for the easy buttons control - size report of the feature switches (host tool, Python)
+
+# Author: dimakomplekt
+
+# Description: Rebuilds button_control.c of the ESP-IDF project with every feature configuration of the table
+# below (the BUTTON_CONTROL_* defines by -D, over the Kconfig menu) by the same compiler and flags, as the
+# project build, and prints text / data / bss of the object and sizeof(button_ctx) per configuration.
+# The flags are taken from the compile_commands.json of the project build, so the numbers are the target
+# ones (xtensa / riscv toolchain, the project optimization level).
+
+# Build:  idf.py build                  (the project with the button_control component)
+# Run:    python3 button_size_report.py build/compile_commands.json
+
+# =========================================================================================== INFO
+
+
+
+# =========================================================================================== IMPORT
+
+import json
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+
+# =========================================================================================== IMPORT
+
+
+# =========================================================================================== CONFIGURATIONS
+
+# Minimal build: one-time press flag API only
+MINIMAL = [
+    "BUTTON_CONTROL_CALLBACKS=0", "BUTTON_CONTROL_VALIDATION=0", "BUTTON_CONTROL_MULTIPRESS=0",
+    "BUTTON_CONTROL_LONG_PRESS=0", "BUTTON_CONTROL_EVENTS=0", "BUTTON_CONTROL_HEALTH=0",
+    "BUTTON_CONTROL_WAKEUP=0", "BUTTON_CONTROL_RETENTION=0", "BUTTON_CONTROL_PUBLISH=0",
+    "BUTTON_CONTROL_ENCODER=0", "BUTTON_CONTROL_PROFILER=0",
+]
+
+# Name and the defines of every configuration (over the project configuration)
+CONFIGURATIONS = [
+    ("project", []),
+    ("no callbacks", ["BUTTON_CONTROL_CALLBACKS=0"]),
+    ("no validation", ["BUTTON_CONTROL_VALIDATION=0"]),
+    ("no multipress", ["BUTTON_CONTROL_MULTIPRESS=0"]),
+    ("no long press", ["BUTTON_CONTROL_LONG_PRESS=0"]),
+    ("no events", ["BUTTON_CONTROL_EVENTS=0"]),
+    ("health", ["BUTTON_CONTROL_HEALTH=1"]),
+    ("no wakeup/retention/publish", ["BUTTON_CONTROL_WAKEUP=0", "BUTTON_CONTROL_RETENTION=0",
+                                     "BUTTON_CONTROL_PUBLISH=0"]),
+    ("no encoder", ["BUTTON_CONTROL_ENCODER=0"]),
+    ("one-time flags only", MINIMAL),
+    ("... with active-low", MINIMAL + ["BUTTON_CONTROL_ACTIVE_LEVEL=BUTTON_ACTIVE_LOW"]),
+]
+
+# sizeof(button_ctx) by the symbol size of the probe object
+CTX_PROBE = '#include "button_control.h"\nchar button_ctx_size[sizeof(button_ctx)] = { 1 };\n'
+
+# =========================================================================================== CONFIGURATIONS
+
+
+# =========================================================================================== HELPER-FUNCTIONS
+
+# Compile command of button_control.c: compiler, flags without the output / input / dependency files
+def compile_command(database_path):
+    with open(database_path) as database:
+        entries = json.load(database)
+
+    for entry in entries:
+        if os.path.basename(entry["file"]) != "button_control.c":
+            continue
+
+        arguments = entry.get("arguments") or shlex.split(entry["command"])
+        flags = []
+        skip = False
+
+        for argument in arguments[1:]:
+            if skip:
+                skip = False
+                continue
+
+            if argument in ("-o", "-MF", "-MT", "-MQ"):
+                skip = True
+                continue
+
+            if argument in ("-c", "-MD", "-MMD") or argument.endswith("button_control.c"):
+                continue
+
+            flags.append(argument)
+
+        source = os.path.join(entry["directory"], entry["file"])
+
+        return arguments[0], flags, entry["directory"], source
+
+    sys.exit("button_control.c is not in %s (is the component in the project build?)" % database_path)
+
+
+# Tool of the same toolchain: xtensa-esp32-elf-gcc -> xtensa-esp32-elf-size
+def toolchain_tool(compiler, tool):
+    return compiler[:-3] + tool if compiler.endswith("gcc") else tool
+
+
+def run(command, directory):
+    result = subprocess.run(command, cwd=directory, capture_output=True, text=True)
+
+    if result.returncode != 0:
+        sys.exit("%s\n%s" % (" ".join(command), result.stderr))
+
+    return result.stdout
+
+
+# text / data / bss of the object (berkeley format of size)
+def object_size(compiler, directory, path):
+    text, data, bss = run([toolchain_tool(compiler, "size"), path], directory).splitlines()[1].split()[:3]
+
+    return int(text), int(data), int(bss)
+
+
+def symbol_size(compiler, directory, path, symbol):
+    for line in run([toolchain_tool(compiler, "nm"), "-S", "--defined-only", path], directory).splitlines():
+        fields = line.split()
+
+        if len(fields) == 4 and fields[3] == symbol:
+            return int(fields[1], 16)
+
+    return 0
+
+# =========================================================================================== HELPER-FUNCTIONS
+
+
+# =========================================================================================== MAIN
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("usage: %s <build/compile_commands.json>" % sys.argv[0])
+
+    compiler, flags, directory, source = compile_command(sys.argv[1])
+    include = "-I" + os.path.dirname(source)
+
+    with tempfile.TemporaryDirectory() as temp:
+        probe = os.path.join(temp, "ctx_probe.c")
+
+        with open(probe, "w") as probe_file:
+            probe_file.write(CTX_PROBE)
+
+        print("%-30s %7s %6s %6s %6s" % ("configuration", "text", "data", "bss", "ctx"))
+
+        for name, defines in CONFIGURATIONS:
+            options = flags + ["-D" + define for define in defines]
+            obj = os.path.join(temp, "button_control.o")
+            probe_obj = os.path.join(temp, "ctx_probe.o")
+
+            run([compiler] + options + ["-c", source, "-o", obj], directory)
+            run([compiler] + options + [include, "-c", probe, "-o", probe_obj], directory)
+
+            text, data, bss = object_size(compiler, directory, obj)
+            ctx = symbol_size(compiler, directory, probe_obj, "button_ctx_size")
+
+            print("%-30s %7d %6d %6d %6d" % (name, text, data, bss, ctx))
+
+
+if __name__ == "__main__":
+    main()
+
+# =========================================================================================== MAIN
@@ -0,0 +1,38 @@
+#!/bin/sh
+
+# ESP32 library for the easy buttons control - host build of the benchmark runner (tools/host)
+#
+# Usage:  ./build.sh [extra -D flags]      e.g. ./build.sh -DBUTTON_CONTROL_HEALTH=1
+# Output: ./button_host_bench, ./button_host_coro (coroutine gestures on the simulated clock)
+#
+# The library sources are built unchanged against the stand-in ESP-IDF headers of ./include and the
+# host port (button_host_port.c). CC / CXX / CFLAGS select the compilers and the optimization.
+
+set -e
+
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+LIB_DIR=$(cd "$HOST_DIR/../.." && pwd)
+BUILD_DIR="$HOST_DIR/build"
+
+CC=${CC:-cc}
+CXX=${CXX:-c++}
+CFLAGS=${CFLAGS:--O2}
+
+FLAGS="$CFLAGS -I$HOST_DIR/include -I$HOST_DIR -I$LIB_DIR -DBUTTON_CONTROL_SIM_INPUT=1 $*"
+
+mkdir -p "$BUILD_DIR/coro"
+
+for SOURCE in "$LIB_DIR/button_control.c" "$LIB_DIR/button_control_bench.c" "$LIB_DIR/button_control_task.c" \
+              "$LIB_DIR/button_control_trace.c" "$LIB_DIR/button_control_event_log.c" \
+              "$LIB_DIR/button_control_event_log_decode.c" "$HOST_DIR/button_host_port.c" "$HOST_DIR/button_host_bench.c"
+do
+    $CC -std=gnu11 $FLAGS -c "$SOURCE" -o "$BUILD_DIR/$(basename "$SOURCE" .c).o"
+done
+
+$CXX -std=gnu++20 $FLAGS -c "$LIB_DIR/button_control_bench_templates.cpp" -o "$BUILD_DIR/button_control_bench_templates.o"
+
+$CXX -std=gnu++20 $FLAGS -c "$HOST_DIR/button_host_coro.cpp" -o "$BUILD_DIR/coro/button_host_coro.o"
+
+$CXX "$BUILD_DIR"/*.o -lm -lpthread -o "$HOST_DIR/button_host_bench"
+$CXX "$BUILD_DIR/coro/button_host_coro.o" "$BUILD_DIR/button_control.o" "$BUILD_DIR/button_host_port.o" -lm -lpthread \
+     -o "$HOST_DIR/button_host_coro"
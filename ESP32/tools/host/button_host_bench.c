@@ -0,0 +1,284 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - host benchmark runner (host tool, С-File)
+
+// Author: dimakomplekt
+
+// Description: Runs the button_control_bench suites on the host port (tools/host/button_host_port.c) and
+// prints their JSON lines to stdout, one line per run (redirect to a file and compare the runs for the
+// hot path regressions). Timings are host ns, the event rates are the same model as on the target.
+
+// Build:  ./build.sh                    (from tools/host, output - ./button_host_bench)
+// Run:    ./button_host_bench [suite] [duration, ms] [event log file, btnlog.bin]
+//
+//   run        - all APIs x bounce models x 1 .. 1024 buttons, then the tickless loop (default suite)
+//   templates  - C API against the C++ templates (button_control.hpp)
+//   replay     - trace record / virtual replay determinism
+//   encoder    - max trackable step rate of the encoder decoding
+//   handoff    - sampler -> consumer event queue under the loaded consumer (pthreads for the tasks)
+//   health     - contact health in the tickless loop (build with BUTTON_CONTROL_HEALTH=1)
+//   event_log  - replayed presses of 8 buttons into the event log, backed by the file (64 pages of 4 KB,
+//                written by the log task), decode it by ../button_event_log_dump
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "button_control_bench.h"
+#include "button_control_event_log.h"
+
+#include "freertos/task.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== SUITES
+
+// Generation time of one run (default - the config default)
+static uint32_t suite_duration_ms;
+
+
+static button_bench_config suite_config(button_bench_api api)
+{
+    button_bench_config config = button_bench_config_default(GPIO_NUM_4, api);
+
+    if (suite_duration_ms) config.duration_ms = suite_duration_ms;
+
+    return config;
+}
+
+
+static void suite_run(void)
+{
+    static const unsigned int buttons[] = { 1, 8, 64, 256, 1024 };
+
+    for (int api = 0; api < BUT_BENCH_API_QUANTITY; api++)
+    {
+        for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+        {
+            for (size_t n = 0; n < sizeof(buttons) / sizeof(buttons[0]); n++)
+            {
+                button_bench_config config = suite_config(api);
+                button_bench_result result;
+
+                config.bounce_model = model;
+                config.buttons_quantity = buttons[n];
+
+                if (button_bench_run(&config, &result)) button_bench_print_result(&config, &result);
+            }
+        }
+    }
+
+    // Light sleep simulation: wakeups of the tickless loop for the same press schedule
+    button_bench_config config = suite_config(BUT_BENCH_FLAG_ONETIME);
+    button_bench_result result;
+
+    config.buttons_quantity = 8;
+    config.tickless = true;
+
+    if (button_bench_run(&config, &result)) button_bench_print_result(&config, &result);
+}
+
+
+static void suite_templates(void)
+{
+    static const button_bench_api apis[] = { BUT_BENCH_FLAG_ONETIME, BUT_BENCH_FLAG_LONGTIME };
+
+    for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+    {
+        for (size_t i = 0; i < sizeof(apis) / sizeof(apis[0]); i++)
+        {
+            button_bench_config config = suite_config(apis[i]);
+
+            config.bounce_model = model;
+
+            button_bench_templates(&config);
+        }
+    }
+}
+
+
+static void suite_replay(void)
+{
+    static const button_bench_api apis[] = { BUT_BENCH_FLAG_ONETIME, BUT_BENCH_FLAG_MULTIPLE,
+                                             BUT_BENCH_FLAG_LONGTIME, BUT_BENCH_CALLBACK_INFINITE };
+
+    for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+    {
+        for (size_t i = 0; i < sizeof(apis) / sizeof(apis[0]); i++)
+        {
+            button_bench_config config = suite_config(apis[i]);
+
+            config.buttons_quantity = 8;
+            config.bounce_model = model;
+
+            button_bench_replay(&config, 1000, 65536);
+        }
+    }
+}
+
+
+static void suite_encoder(void)
+{
+    button_bench_encoder(GPIO_NUM_18, GPIO_NUM_19, 1000, 0, 0);        // Ideal encoder, exact period
+    button_bench_encoder(GPIO_NUM_18, GPIO_NUM_19, 1000, 20, 10);      // Real encoder, loop jitter
+    button_bench_encoder(GPIO_NUM_33, GPIO_NUM_34, 500, 40, 0);        // High bank pins, bad phase
+}
+
+
+static void suite_handoff(void)
+{
+    static const uint32_t loads_us[] = { 0, 1000, 5000, 20000 };
+
+    for (size_t load = 0; load < sizeof(loads_us) / sizeof(loads_us[0]); load++)
+    {
+        button_bench_config config = suite_config(BUT_BENCH_CALLBACK_ONETIME);
+
+        config.buttons_quantity = 64;
+        config.idle_mean_ms = 200;
+
+        button_bench_handoff(&config, loads_us[load], 16, 1);
+    }
+}
+
+
+#if BUTTON_CONTROL_HEALTH && BUTTON_CONTROL_WAKEUP
+
+static void suite_health(void)
+{
+    for (int model = 0; model < BUT_BOUNCE_QUANTITY; model++)
+    {
+        button_bench_config config = suite_config(BUT_BENCH_FLAG_ONETIME);
+
+        config.buttons_quantity = 8;
+        config.bounce_model = model;
+
+        button_bench_health_tickless(&config);
+    }
+}
+
+#endif
+
+
+#define SUITE_LOG_PAGE_SIZE 4096
+#define SUITE_LOG_PAGES 64
+
+static FILE *log_file;
+static uint64_t log_data_bytes;                 // Packed events bytes of the written pages
+
+
+// File storage of the log: page slot - offset in the file
+static bool suite_log_file_writer(uint32_t page_slot, const uint8_t *page, uint32_t size, void *user)
+{
+    (void)user;
+
+    log_data_bytes += (uint32_t)(page[12] | (page[13] << 8));
+
+    if (fseek(log_file, (long)page_slot * size, SEEK_SET) != 0) return false;
+
+    return fwrite(page, 1, size, log_file) == size && fflush(log_file) == 0;
+}
+
+
+// Log task: the writer is never called from the button APIs
+static void suite_log_task(void *parameter)
+{
+    button_event_log *log = (button_event_log *)parameter;
+
+    while (true)
+    {
+        if (button_event_log_pending(log)) button_event_log_flush(log);
+        else vTaskDelay(1);
+    }
+}
+
+
+static void suite_event_log(const char *path)
+{
+    static uint8_t pages[2][SUITE_LOG_PAGE_SIZE];
+    static uint8_t erased[SUITE_LOG_PAGE_SIZE];
+    static button_event_log log;
+
+    log_file = fopen(path, "w+b");
+
+    if (log_file == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return;
+    }
+
+    // Erased storage
+    memset(erased, 0xFF, sizeof(erased));
+
+    for (int slot = 0; slot < SUITE_LOG_PAGES; slot++) fwrite(erased, 1, sizeof(erased), log_file);
+
+    button_event_log_init(&log, pages[0], pages[1], SUITE_LOG_PAGE_SIZE, SUITE_LOG_PAGES, suite_log_file_writer,
+                          NULL, 0);
+    button_event_log_attach(&log);
+
+    xTaskCreate(suite_log_task, "button_log", 4096, &log, 2, NULL);
+
+    // Replayed runs on the virtual clock: all press APIs, chatter contacts
+    static const button_bench_api apis[] = { BUT_BENCH_FLAG_ONETIME, BUT_BENCH_FLAG_MULTIPLE,
+                                             BUT_BENCH_FLAG_LONGTIME, BUT_BENCH_CALLBACK_INFINITE };
+
+    for (size_t i = 0; i < sizeof(apis) / sizeof(apis[0]); i++)
+    {
+        button_bench_config config = suite_config(apis[i]);
+
+        config.buttons_quantity = 8;
+        config.bounce_model = BUT_BOUNCE_EXPONENTIAL_CHATTER;
+
+        button_bench_replay(&config, 1000, 1 << 20);
+    }
+
+    // Last events: closed by the button side, written by the log task
+    while (!button_event_log_close(&log)) vTaskDelay(1);
+    while (button_event_log_pending(&log)) vTaskDelay(1);
+
+    fclose(log_file);
+
+    printf("{\"bench\":\"button_control_event_log\",\"file\":\"%s\",\"page_size\":%u,\"pages\":%u,"
+           "\"events\":%u,\"dropped\":%u,\"pages_written\":%u,\"write_errors\":%u,\"data_bytes\":%llu,"
+           "\"bytes_per_event\":%.2f}\n",
+           path, SUITE_LOG_PAGE_SIZE, SUITE_LOG_PAGES, (unsigned)log.events_logged, (unsigned)log.events_dropped,
+           (unsigned)log.pages_written, (unsigned)log.write_errors, (unsigned long long)log_data_bytes,
+           log.events_logged ? (double)log_data_bytes / log.events_logged : 0.0);
+}
+
+// =========================================================================================== SUITES
+
+
+// =========================================================================================== MAIN
+
+int main(int argc, char **argv)
+{
+    const char *suite = (argc > 1) ? argv[1] : "run";
+
+    if (argc > 2) suite_duration_ms = (uint32_t)strtoul(argv[2], NULL, 0);
+
+    if (strcmp(suite, "run") == 0) suite_run();
+    else if (strcmp(suite, "templates") == 0) suite_templates();
+    else if (strcmp(suite, "replay") == 0) suite_replay();
+    else if (strcmp(suite, "encoder") == 0) suite_encoder();
+    else if (strcmp(suite, "handoff") == 0) suite_handoff();
+    else if (strcmp(suite, "event_log") == 0) suite_event_log((argc > 3) ? argv[3] : "btnlog.bin");
+#if BUTTON_CONTROL_HEALTH && BUTTON_CONTROL_WAKEUP
+    else if (strcmp(suite, "health") == 0) suite_health();
+#endif
+    else
+    {
+        fprintf(stderr, "usage: %s [run | templates | replay | encoder | handoff | health | event_log] [duration, ms] [log file]\n", argv[0]);
+        return 2;
+    }
+
+    return 0;
+}
+
+// =========================================================================================== MAIN
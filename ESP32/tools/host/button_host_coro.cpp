@@ -0,0 +1,153 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - coroutine gestures on the simulated clock (host tool, С++-File)
+
+// Author: dimakomplekt
+
+// Description: Drives Scheduler::run(now_us) of button_control_coro.hpp by the virtual clock: the button
+// engine time (button_time_source_set) and the pin levels (button_input_source_set) follow the press
+// script, one loop pass per simulated ms, so the resume times are exact and repeat on every run.
+// Prints one JSON line per resumed co_await and returns 1 if any resume is off its expected time.
+
+// Build:  ./build.sh                    (from tools/host, output - ./button_host_coro)
+// Run:    ./button_host_coro
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#include <cstdio>
+
+#include "button_control_coro.hpp"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== SIMULATION
+
+using namespace button_control;
+using namespace std::chrono_literals;
+
+#define HOST_CORO_DEBOUNCE_MS 3             // Debounce await of the button APIs
+
+static int64_t virtual_now_us = 0;
+
+// Press script of one pin: [press_ms, release_ms)
+struct ScriptPress
+{
+    gpio_num_t PIN;
+    int64_t press_ms;
+    int64_t release_ms;
+};
+
+static const ScriptPress script[] = {
+
+    { GPIO_NUM_4,   100,  2100 },       // 2 s hold: long_press(1s) - shorter than the APIs long-time press
+    { GPIO_NUM_4,  3000,  3400 },       // Short tap: no long press
+    { GPIO_NUM_4,  4000, 10000 },       // 6 s hold: long_press(5s) - longer than the APIs long-time press
+    { GPIO_NUM_5, 11000, 11100 },       // Short press
+
+};
+
+static int64_t virtual_clock(void)
+{
+    return virtual_now_us;
+}
+
+
+// Active-low pullup buttons: 0 - pressed
+static int virtual_levels(const button_ctx *button)
+{
+    int64_t now_ms = virtual_now_us / 1000;
+
+    for (const ScriptPress &press : script)
+    {
+        if (press.PIN == button->PIN && now_ms >= press.press_ms && now_ms < press.release_ms) return 0;
+    }
+
+    return 1;
+}
+
+// =========================================================================================== SIMULATION
+
+
+// =========================================================================================== FLOW
+
+static button_ctx but_menu;
+static button_ctx but_ok;
+
+static AwaitButton menu(but_menu);
+static AwaitButton ok(but_ok);
+
+static int mismatches = 0;
+static bool flow_done = false;
+
+
+static void report(const char *await, const button_event &event, int64_t expected_ms)
+{
+    int64_t resumed_ms = virtual_now_us / 1000;
+
+    if (resumed_ms != expected_ms) mismatches += 1;
+
+    printf("{\"bench\":\"button_control_coro\",\"await\":\"%s\",\"resumed_ms\":%lld,\"expected_ms\":%lld,"
+           "\"hold_ms\":%u,\"count\":%u}\n",
+           await, (long long)resumed_ms, (long long)expected_ms, (unsigned)event.hold_ms, (unsigned)event.count);
+}
+
+
+// Expected times: press time + debounce (the press start) + the awaited hold, the release for the press
+static Task gestures_flow()
+{
+    button_event event = co_await menu.long_press(1s);
+    report("menu.long_press(1s)", event, 100 + HOST_CORO_DEBOUNCE_MS + 1000);
+
+    event = co_await menu.long_press(5s);
+    report("menu.long_press(5s)", event, 4000 + HOST_CORO_DEBOUNCE_MS + 5000);
+
+    event = co_await ok.pressed();
+    report("ok.pressed()", event, 11100);     // On the release
+
+    flow_done = true;
+}
+
+// =========================================================================================== FLOW
+
+
+// =========================================================================================== MAIN
+
+int main()
+{
+    button_time_source_set(virtual_clock);
+    button_input_source_set(virtual_levels);
+
+    but_menu = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    but_ok = button_initialization(GPIO_NUM_5, GPIO_PULLUP_ONLY, NO_FIX);
+
+    bool long_flag = false;
+
+    Scheduler::start();
+
+    if (!gestures_flow()) return 2;
+
+    // One loop pass per simulated ms: the button APIs report the events, the run resumes the coroutines
+    for (virtual_now_us = 0; virtual_now_us < 15000000 && !flow_done; virtual_now_us += 1000)
+    {
+        flag_control_by_but_longtime_press(&but_menu, &long_flag);
+        callback_control_by_but_onetime_press(&but_ok, 1);
+
+        Scheduler::run(virtual_now_us);
+    }
+
+    Scheduler::stop();
+
+    button_time_source_set(NULL);
+    button_input_source_set(NULL);
+
+    if (!flow_done) mismatches += 1;
+
+    return (mismatches != 0);
+}
+
+// =========================================================================================== MAIN
@@ -0,0 +1,457 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - host port (С-File)
+
+// Author: dimakomplekt
+
+// Description: ESP-IDF / FreeRTOS / async_await subset for the host builds (see the header).
+
+// Instruction - at the end of the file.
+
+// =========================================================================================== INFO
+
+
+
+// =========================================================================================== IMPORT
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "button_host_port.h"
+
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "soc/gpio_reg.h"
+#include "my_libs/async_await/async_await.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== VARIABLES
+
+// Host input registers: all pins are high (released pullup buttons)
+volatile uint32_t button_host_gpio_in[2] = { 0xFFFFFFFFu, 0xFFFFFFFFu };
+
+// FreeRTOS task of the pthread
+struct button_host_task
+{
+    pthread_t thread;
+    TaskFunction_t function;
+    void *parameter;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t notified;
+    uint32_t notify_count;                      // Task notify value (xTaskNotifyGive / ulTaskNotifyTake)
+};
+
+static __thread struct button_host_task *current_task;
+
+// =========================================================================================== VARIABLES
+
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+static int64_t host_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+
+static void host_sleep_us(int64_t us)
+{
+    if (us <= 0) return;
+
+    struct timespec time = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+
+    while (nanosleep(&time, &time) != 0);
+}
+
+
+static struct button_host_task *host_task_new(TaskFunction_t function, void *parameter)
+{
+    struct button_host_task *task = calloc(1, sizeof(struct button_host_task));
+
+    if (task == NULL) return NULL;
+
+    task->function = function;
+    task->parameter = parameter;
+
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->notified, NULL);
+
+    return task;
+}
+
+
+static void *host_task_thread(void *parameter)
+{
+    current_task = (struct button_host_task *)parameter;
+    current_task->function(current_task->parameter);
+
+    return NULL;
+}
+
+
+static int64_t host_time_unit_us(uint32_t time, time_unit unit)
+{
+    if (unit == TIME_UNIT_US) return time;
+    if (unit == TIME_UNIT_MS) return (int64_t)time * 1000;
+
+    return (int64_t)time * 1000000;
+}
+
+// =========================================================================================== HELPER-FUNCTIONS
+
+
+// =========================================================================================== ESP-IDF
+
+void button_host_gpio_level_set(gpio_num_t PIN, int level)
+{
+    volatile uint32_t *bank = &button_host_gpio_in[PIN >= 32];
+    uint32_t bit = 1u << (PIN & 31);
+
+    if (level) *bank |= bit;
+    else *bank &= ~bit;
+}
+
+
+int64_t esp_timer_get_time(void)
+{
+    return host_time_ns() / 1000;
+}
+
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    return (esp_cpu_cycle_count_t)host_time_ns();
+}
+
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return 1000;
+}
+
+
+void esp_rom_delay_us(uint32_t us)
+{
+    int64_t end_ns = host_time_ns() + (int64_t)us * 1000;
+
+    while (host_time_ns() < end_ns);
+}
+
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return (config->pin_bit_mask >> GPIO_NUM_MAX) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+
+esp_err_t gpio_set_direction(gpio_num_t PIN, gpio_mode_t mode)
+{
+    (void)mode;
+
+    return GPIO_IS_VALID_GPIO(PIN) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+
+esp_err_t gpio_set_pull_mode(gpio_num_t PIN, gpio_pull_mode_t pull_mode)
+{
+    (void)pull_mode;
+
+    return GPIO_IS_VALID_GPIO(PIN) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+
+int gpio_get_level(gpio_num_t PIN)
+{
+    return (button_host_gpio_in[PIN >= 32] >> (PIN & 31)) & 0x1;
+}
+
+// =========================================================================================== ESP-IDF
+
+
+// =========================================================================================== FREERTOS
+
+BaseType_t xPortInIsrContext(void)
+{
+    return pdFALSE;
+}
+
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *parameter,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)name;
+    (void)stack_size;
+    (void)priority;
+    (void)core;
+
+    struct button_host_task *task = host_task_new(function, parameter);
+
+    if (task == NULL) return pdFAIL;
+
+    // Handle is valid before the task runs (like the FreeRTOS one)
+    if (handle) *handle = task;
+
+    if (pthread_create(&task->thread, NULL, host_task_thread, task) != 0)
+    {
+        free(task);
+        return pdFAIL;
+    }
+
+    pthread_detach(task->thread);
+
+    return pdPASS;
+}
+
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size, void *parameter,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_size, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Other tasks are not deleted on the host (no use in the library)
+    if (task != NULL && task != current_task) return;
+
+    pthread_exit(NULL);
+}
+
+
+void vTaskDelay(TickType_t ticks)
+{
+    host_sleep_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+    *previous_wake += increment;
+
+    host_sleep_us(((int64_t)(TickType_t)(*previous_wake - xTaskGetTickCount())) * portTICK_PERIOD_MS * 1000);
+}
+
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(host_time_ns() / 1000000 / portTICK_PERIOD_MS);
+}
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    // Threads, that are not created by xTaskCreate (main), get their task at the first call
+    if (current_task == NULL)
+    {
+        current_task = host_task_new(NULL, NULL);
+        if (current_task) current_task->thread = pthread_self();
+    }
+
+    return current_task;
+}
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->mutex);
+
+    task->notify_count += 1;
+    pthread_cond_signal(&task->notified);
+
+    pthread_mutex_unlock(&task->mutex);
+
+    return pdPASS;
+}
+
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_woken)
+{
+    xTaskNotifyGive(task);
+
+    if (higher_priority_woken) *higher_priority_woken = pdFALSE;
+}
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait_ticks)
+{
+    struct button_host_task *task = xTaskGetCurrentTaskHandle();
+
+    pthread_mutex_lock(&task->mutex);
+
+    if (task->notify_count == 0 && wait_ticks != 0)
+    {
+        if (wait_ticks == portMAX_DELAY)
+        {
+            while (task->notify_count == 0) pthread_cond_wait(&task->notified, &task->mutex);
+        }
+        else
+        {
+            struct timespec deadline;
+            int64_t deadline_ns;
+
+            clock_gettime(CLOCK_REALTIME, &deadline);
+
+            deadline_ns = (int64_t)deadline.tv_sec * 1000000000LL + deadline.tv_nsec +
+                          (int64_t)wait_ticks * portTICK_PERIOD_MS * 1000000LL;
+
+            deadline.tv_sec = deadline_ns / 1000000000LL;
+            deadline.tv_nsec = deadline_ns % 1000000000LL;
+
+            while (task->notify_count == 0)
+            {
+                if (pthread_cond_timedwait(&task->notified, &task->mutex, &deadline) != 0) break;
+            }
+        }
+    }
+
+    uint32_t value = task->notify_count;
+
+    if (value) task->notify_count = clear ? 0 : value - 1;
+
+    pthread_mutex_unlock(&task->mutex);
+
+    return value;
+}
+
+
+void vTaskSetTimeOutState(TimeOut_t *timeout)
+{
+    timeout->entered = xTaskGetTickCount();
+}
+
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *wait_ticks)
+{
+    if (*wait_ticks == portMAX_DELAY) return pdFALSE;
+
+    TickType_t now = xTaskGetTickCount();
+    TickType_t elapsed = now - timeout->entered;
+
+    if (elapsed >= *wait_ticks)
+    {
+        *wait_ticks = 0;
+        return pdTRUE;
+    }
+
+    // Rest of the wait from now
+    *wait_ticks -= elapsed;
+    timeout->entered = now;
+
+    return pdFALSE;
+}
+
+// =========================================================================================== FREERTOS
+
+
+// =========================================================================================== ASYNC AWAIT
+
+async_await_ctx async_await_ctx_default(void)
+{
+    return (async_await_ctx){ .start_us = 0, .end_flag = false, .running = false };
+}
+
+
+// Started by the first call, true after the time (restart - the next call starts it again)
+bool async_await(async_await_ctx *ctx, uint32_t time, time_unit unit, bool restart)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    if (!ctx->running)
+    {
+        ctx->running = true;
+        ctx->end_flag = false;
+        ctx->start_us = now_us;
+    }
+
+    if (now_us - ctx->start_us < host_time_unit_us(time, unit)) return false;
+
+    ctx->end_flag = true;
+
+    if (restart) ctx->running = false;
+
+    return true;
+}
+
+
+void end_await(async_await_ctx *ctx)
+{
+    ctx->running = false;
+    ctx->end_flag = false;
+}
+
+
+void reboot_await(async_await_ctx *ctx, uint32_t time, time_unit unit)
+{
+    (void)time;
+    (void)unit;
+
+    ctx->running = true;
+    ctx->end_flag = false;
+    ctx->start_us = esp_timer_get_time();
+}
+
+
+void await(uint32_t time, time_unit unit)
+{
+    host_sleep_us(host_time_unit_us(time, unit));
+}
+
+// =========================================================================================== ASYNC AWAIT
+
+
+// =========================================================================================== USING EXAMPLES SECTION
+
+/*
+
+// Host program against the library: the library sources, this file and the stand-in headers
+//
+//   cc -std=gnu11 -O2 -Itools/host/include -Itools/host -I. -DBUTTON_CONTROL_SIM_INPUT=1 \
+//      app.c button_control.c tools/host/button_host_port.c -lm -lpthread -o app
+//
+// The ready runner of the benchmarks is tools/host/button_host_bench.c (build: tools/host/build.sh).
+
+#include "button_control.h"
+#include "button_host_port.h"
+
+int main(void)
+{
+    button_ctx button = button_initialization(GPIO_NUM_4, GPIO_PULLUP_ONLY, NO_FIX);
+    bool pressed = false;
+
+    button_host_gpio_level_set(GPIO_NUM_4, 0);      // Press
+
+    for (int i = 0; i < 20; i++)
+    {
+        flag_control_by_but_onetime_press(&button, &pressed);
+        await(1, TIME_UNIT_MS);
+    }
+
+    button_host_gpio_level_set(GPIO_NUM_4, 1);      // Release - the onetime press is reported
+    flag_control_by_but_onetime_press(&button, &pressed);
+
+    printf("pressed %d\n", pressed);
+}
+
+*/
+
+// =========================================================================================== USING EXAMPLES SECTION
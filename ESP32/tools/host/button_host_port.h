@@ -0,0 +1,44 @@
+// =========================================================================================== INFO
+
+// ESP32 library for the easy buttons control - host port (Header File, C version)
+
+// Author: dimakomplekt
+
+// Description: ESP-IDF / FreeRTOS / async_await subset for the host builds of the library (Linux, macOS):
+// the monotonic clock for esp_timer and the cycle counter (1 "cycle" = 1 ns), pin levels in the host
+// input registers, FreeRTOS tasks on pthreads (core affinity and priorities are ignored, 1 ms ticks).
+// The stand-in headers are in tools/host/include, the library sources are built unchanged.
+
+// Instruction - at the end of the C-file.
+
+// =========================================================================================== INFO
+
+#ifndef BUTTON_HOST_PORT_H
+#define BUTTON_HOST_PORT_H
+
+// =========================================================================================== IMPORT
+
+#include "hal/gpio_types.h"
+
+// =========================================================================================== IMPORT
+
+
+// =========================================================================================== API
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Function: button_host_gpio_level_set
+// Purpose: Set the level of the host pin (read by the library from the host GPIO_IN_REG / GPIO_IN1_REG).
+// Call as: button_host_gpio_level_set(GPIO_NUM_4, 0);     // Pullup button is pressed
+void button_host_gpio_level_set(gpio_num_t PIN, int level);
+
+#ifdef __cplusplus
+}
+#endif
+
+// =========================================================================================== API
+
+
+#endif // BUTTON_HOST_PORT_H
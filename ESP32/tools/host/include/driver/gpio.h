@@ -0,0 +1,23 @@
+// Host port of the button_control (tools/host): ESP-IDF driver/gpio.h subset
+// (pins are the host input registers of soc/gpio_reg.h, set by button_host_gpio_level_set)
+
+#pragma once
+
+#include "esp_err.h"
+#include "hal/gpio_types.h"
+
+// ESP32 pins: 0..39 without 20, 24, 28..31
+#define GPIO_IS_VALID_GPIO(PIN) ((PIN) >= 0 && (PIN) < GPIO_NUM_MAX && ((1ULL << (PIN)) & 0xF1100000ULL) == 0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t gpio_config(const gpio_config_t *config);
+esp_err_t gpio_set_direction(gpio_num_t PIN, gpio_mode_t mode);
+esp_err_t gpio_set_pull_mode(gpio_num_t PIN, gpio_pull_mode_t pull_mode);
+int gpio_get_level(gpio_num_t PIN);
+
+#ifdef __cplusplus
+}
+#endif
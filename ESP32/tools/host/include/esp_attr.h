@@ -0,0 +1,8 @@
+// Host port of the button_control (tools/host): ESP-IDF esp_attr.h subset (no IRAM / DRAM on the host)
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,18 @@
+// Host port of the button_control (tools/host): ESP-IDF esp_cpu.h subset
+// (1 "cycle" = 1 ns of the monotonic clock, see esp_rom_get_cpu_ticks_per_us)
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+#ifdef __cplusplus
+}
+#endif
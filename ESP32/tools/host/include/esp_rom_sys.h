@@ -0,0 +1,16 @@
+// Host port of the button_control (tools/host): ESP-IDF esp_rom_sys.h subset
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void);    // 1000: the host "cycles" are ns
+void esp_rom_delay_us(uint32_t us);             // Busy wait, like the ROM delay
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,15 @@
+// Host port of the button_control (tools/host): ESP-IDF esp_timer.h subset (monotonic clock, us)
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
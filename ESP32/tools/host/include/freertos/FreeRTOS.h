@@ -0,0 +1,35 @@
+// Host port of the button_control (tools/host): FreeRTOS.h subset (tasks are pthreads, 1 ms ticks)
+
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+
+#define pdMS_TO_TICKS(MS) ((TickType_t)(((uint64_t)(MS) * configTICK_RATE_HZ) / 1000))
+
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xPortInIsrContext(void);             // Always 0: no ISRs on the host
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
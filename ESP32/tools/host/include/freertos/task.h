@@ -0,0 +1,43 @@
+// Host port of the button_control (tools/host): FreeRTOS task.h subset
+// (task - pthread, notify - counter under the mutex, core affinity is ignored)
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct button_host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef struct
+{
+    TickType_t entered;
+
+} TimeOut_t;
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *parameter,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size, void *parameter,
+                       UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t task);            // Only NULL (the calling task) is supported
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait_ticks);
+
+void vTaskSetTimeOutState(TimeOut_t *timeout);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *wait_ticks);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+// Host port of the button_control (tools/host): async_await lib interface used by the button_control
+// (the same calls, realized on the esp_timer_get_time of the host port)
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum { TIME_UNIT_US, TIME_UNIT_MS, TIME_UNIT_S } time_unit;
+
+// Await context
+typedef struct
+{
+    int64_t start_us;                           // Await start time
+    bool end_flag;                              // Await is ended
+    bool running;                               // Await is started
+
+} async_await_ctx;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+async_await_ctx async_await_ctx_default(void);
+bool async_await(async_await_ctx *ctx, uint32_t time, time_unit unit, bool restart);
+void end_await(async_await_ctx *ctx);
+void reboot_await(async_await_ctx *ctx, uint32_t time, time_unit unit);
+void await(uint32_t time, time_unit unit);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+// Host port of the button_control (tools/host): ESP-IDF sdkconfig.h subset
+
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32 1               // GPIO bank layout of the ESP32 (GPIO_IN_REG + GPIO_IN1_REG)
+#define CONFIG_FREERTOS_HZ 1000                 // Host ticks: 1 ms
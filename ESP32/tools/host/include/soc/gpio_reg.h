@@ -0,0 +1,21 @@
+// Host port of the button_control (tools/host): ESP-IDF soc/gpio_reg.h subset
+// (the input registers are host variables, button_host_gpio_level_set writes them)
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile uint32_t button_host_gpio_in[2];
+
+#ifdef __cplusplus
+}
+#endif
+
+#define GPIO_IN_REG 0
+#define GPIO_IN1_REG 1
+
+#define REG_READ(REG) (button_host_gpio_in[(REG)])